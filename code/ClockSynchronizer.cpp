@@ -0,0 +1,142 @@
+#include "mtsFBGSensor/mtsFBGSensor/ClockSynchronizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    double Median(std::vector<double>& values)
+    {
+        size_t middle = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + middle, values.end());
+
+        return values[middle];
+    }
+
+} // namespace
+
+void ClockSynchronizer::Configure(const Json::Value& jsonConfig)
+{
+    m_Enabled = jsonConfig.get("Enabled", true).asBool();
+
+    if (jsonConfig.isMember("Window"))
+        m_Window = jsonConfig["Window"].asDouble();
+
+    if (jsonConfig.isMember("Segments"))
+        m_NumSegments = std::max(jsonConfig["Segments"].asUInt(), 3u);
+
+    if (jsonConfig.isMember("Fixed_Delay"))
+        m_FixedDelay = jsonConfig["Fixed_Delay"].asDouble();
+
+    if (jsonConfig.isMember("Jump_Threshold"))
+        m_JumpThreshold = jsonConfig["Jump_Threshold"].asDouble();
+
+    Reset();
+}
+
+void ClockSynchronizer::Reset()
+{
+    m_HasReference   = false;
+    m_IsSynchronized = false;
+    m_Segments.clear();
+
+    m_Offset     = 0.0;
+    m_Skew       = 0.0;
+    m_LastOffset = 0.0;
+    m_Delay      = 0.0;
+    m_NumSamples = 0;
+}
+
+void ClockSynchronizer::AddSample(const double instrumentTime, const double hostTime)
+{
+    if (std::isnan(instrumentTime) || std::isnan(hostTime))
+        return;
+
+    // relative times keep the regression well conditioned with epoch timestamps
+    if (!m_HasReference)
+    {
+        m_Reference    = instrumentTime;
+        m_HasReference = true;
+    }
+
+    double time   = instrumentTime - m_Reference;
+    double offset = hostTime - instrumentTime;
+
+    // a step of either clock (or a reconnected instrument) invalidates the history
+    if (!m_Segments.empty() && std::abs(offset - (m_Offset + m_Skew * time)) > m_JumpThreshold + m_Delay - m_FixedDelay)
+    {
+        Reset();
+        AddSample(instrumentTime, hostTime);
+        return;
+    }
+
+    double segmentLength = m_Window / m_NumSegments;
+    if (m_Segments.empty() || time - m_Segments.back().Start >= segmentLength)
+    {
+        m_Segments.push_back({time, time, offset});
+
+        while (m_Segments.size() > m_NumSegments + 1)
+            m_Segments.pop_front();
+
+        Fit();
+    }
+    else if (offset < m_Segments.back().MinOffset)
+    {
+        m_Segments.back().MinTime   = time;
+        m_Segments.back().MinOffset = offset;
+    }
+
+    // until a line can be fitted, the envelope is the smallest difference seen
+    if (!m_IsSynchronized)
+    {
+        double minOffset = offset;
+        for (const Segment& segment : m_Segments)
+            minOffset = std::min(minOffset, segment.MinOffset);
+
+        m_Offset = minOffset;
+    }
+
+    m_LastOffset = m_Offset + m_Skew * time - m_FixedDelay;
+
+    double delay = offset - m_LastOffset;
+    m_Delay = m_NumSamples == 0 ? delay : m_Delay + m_DelayWeight * (delay - m_Delay);
+    m_NumSamples++;
+}
+
+void ClockSynchronizer::Fit()
+{
+    // only closed segments have a settled minimum
+    size_t numClosed = m_Segments.size() - 1;
+    if (numClosed < 3)
+        return;
+
+    m_Slopes.clear();
+    for (size_t i = 0; i < numClosed; i++)
+        for (size_t j = i + 1; j < numClosed; j++)
+        {
+            double dt = m_Segments[j].MinTime - m_Segments[i].MinTime;
+            if (dt > 0.0)
+                m_Slopes.push_back((m_Segments[j].MinOffset - m_Segments[i].MinOffset) / dt);
+        }
+
+    if (m_Slopes.empty())
+        return;
+
+    m_Skew = Median(m_Slopes);
+
+    // the envelope passes under the minima; a median of the intercepts still ignores a congested segment
+    m_Slopes.clear();
+    for (size_t i = 0; i < numClosed; i++)
+        m_Slopes.push_back(m_Segments[i].MinOffset - m_Skew * m_Segments[i].MinTime);
+
+    m_Offset         = Median(m_Slopes);
+    m_IsSynchronized = true;
+}
+
+double ClockSynchronizer::ToHostTime(const double instrumentTime) const
+{
+    if (!m_HasReference)
+        return instrumentTime;
+
+    return instrumentTime + m_Offset + m_Skew * (instrumentTime - m_Reference) - m_FixedDelay;
+}
@@ -0,0 +1,129 @@
+#include "mtsFBGSensor/SensorFilters/CommonModeCompensator.h"
+
+#include <algorithm>
+
+#include <cisstCommon/cmnLogger.h>
+
+#include "mtsFBGSensor/Utilities/SIMDLane.h"
+
+void CommonModeCompensator::Configure(const Json::Value& jsonConfig)
+{
+    m_Enabled = jsonConfig.get("Enabled", true).asBool();
+    m_Groups.clear();
+
+    const Json::Value& jsonGroups = jsonConfig["Groups"];
+    for (Json::Value::ArrayIndex i = 0; i < jsonGroups.size(); i++)
+    {
+        const Json::Value& jsonGroup = jsonGroups[i];
+
+        Group group;
+        const Json::Value& jsonIndices = jsonGroup["Indices"];
+        for (Json::Value::ArrayIndex j = 0; j < jsonIndices.size(); j++)
+            group.Indices.push_back(jsonIndices[j].asUInt());
+
+        if (jsonGroup.isMember("Reference_Index"))
+            group.ReferenceIndex = jsonGroup["Reference_Index"].asInt();
+
+        if (jsonGroup.isMember("Gain"))
+            group.Gain = jsonGroup["Gain"].asDouble();
+
+        if (group.Indices.empty())
+        {
+            CMN_LOG_INIT_ERROR << "CommonModeCompensator: group " << i << " has no \"Indices\""
+                               << ", disabling the compensation" << std::endl;
+            m_Enabled = false;
+            continue;
+        }
+
+        m_Groups.push_back(group);
+    }
+
+    if (m_Groups.empty())
+        m_Enabled = false;
+
+    if (m_NumChannels > 0)
+        SetNumberOfChannels(m_NumChannels);
+}
+
+void CommonModeCompensator::SetNumberOfChannels(const size_t numChannels)
+{
+    m_NumChannels = numChannels;
+    m_Stride      = SIMDLane::PaddedSize(m_Groups.size());
+
+    // one row per source of the largest group; a reference is a single source of weight 1
+    m_NumRows = 0;
+    for (const Group& group : m_Groups)
+        m_NumRows = std::max(m_NumRows, group.ReferenceIndex >= 0 ? size_t(1) : group.Indices.size());
+
+    // unused entries read shift 0 with weight 0
+    m_SourceIndices.assign(m_NumRows * m_Stride, 0);
+    m_SourceWeights.assign(m_NumRows * m_Stride, 0.0);
+    m_Sources.assign(m_NumRows * m_Stride, 0.0);
+    m_Sums.assign(m_Stride, 0.0);
+    m_Targets.clear();
+
+    for (size_t g = 0; g < m_Groups.size(); g++)
+    {
+        const Group& group = m_Groups[g];
+
+        bool isValid = group.ReferenceIndex < int(numChannels);
+        for (size_t index : group.Indices)
+            isValid = isValid && index < numChannels;
+
+        if (!isValid)
+        {
+            CMN_LOG_RUN_ERROR << "CommonModeCompensator: group " << g << " has an index beyond the "
+                              << numChannels << " FBGs, disabling the compensation" << std::endl;
+            m_Enabled = false;
+            return;
+        }
+
+        if (group.ReferenceIndex >= 0)
+        {
+            m_SourceIndices[g] = size_t(group.ReferenceIndex);
+            m_SourceWeights[g] = 1.0;
+        }
+        else
+        {
+            for (size_t r = 0; r < group.Indices.size(); r++)
+            {
+                m_SourceIndices[r * m_Stride + g] = group.Indices[r];
+                m_SourceWeights[r * m_Stride + g] = 1.0 / double(group.Indices.size());
+            }
+        }
+
+        for (size_t index : group.Indices)
+            m_Targets.push_back(std::make_pair(index, g));
+    }
+
+    m_CommonModes.SetSize(m_Groups.size());
+    m_CommonModes.SetAll(0.0);
+}
+
+void CommonModeCompensator::Process(vctDoubleVec& shifts)
+{
+    if (shifts.size() != m_NumChannels)
+        SetNumberOfChannels(shifts.size());
+
+    if (!m_Enabled)
+        return;
+
+    // gather the sources, then every group's weighted sum a lane of groups at a time
+    for (size_t i = 0; i < m_SourceIndices.size(); i++)
+        m_Sources[i] = shifts[m_SourceIndices[i]];
+
+    for (size_t g = 0; g < m_Stride; g += SIMDLane::WIDTH)
+    {
+        SIMDLane::Lane sum = SIMDLane::Set(0.0);
+        for (size_t r = 0; r < m_NumRows; r++)
+            sum = SIMDLane::MulAdd(SIMDLane::Load(m_SourceWeights.data() + r * m_Stride + g), SIMDLane::Load(m_Sources.data() + r * m_Stride + g), sum);
+
+        SIMDLane::Store(m_Sums.data() + g, sum);
+    }
+
+    for (size_t g = 0; g < m_Groups.size(); g++)
+        m_CommonModes[g] = m_Sums[g];
+
+    for (const std::pair<size_t, size_t>& target : m_Targets)
+        shifts[target.first] -= m_Groups[target.second].Gain * m_Sums[target.second];
+}
@@ -0,0 +1,116 @@
+#include "mtsFBGSensor/Streaming/FBGMulticastPublisher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+void FBGMulticastPublisher::Configure(const Json::Value& jsonConfig)
+{
+    if (jsonConfig.isMember("Group"))
+        m_Group = jsonConfig["Group"].asString();
+
+    if (jsonConfig.isMember("Port"))
+        m_Port = uint16_t(jsonConfig["Port"].asUInt());
+
+    if (jsonConfig.isMember("Interface"))
+        m_Interface = jsonConfig["Interface"].asString();
+
+    if (jsonConfig.isMember("TTL"))
+        m_TTL = jsonConfig["TTL"].asInt();
+
+    if (jsonConfig.isMember("Loopback"))
+        m_Loopback = jsonConfig["Loopback"].asBool();
+
+    if (jsonConfig.isMember("Streams"))
+    {
+        for (Stream& stream : m_Streams)
+            stream.IsEnabled = false;
+
+        for (const Json::Value& jsonStream : jsonConfig["Streams"])
+        {
+            FBGStream::StreamId streamId;
+            if (FBGStream::ParseStreamId(jsonStream.asString(), streamId))
+                m_Streams[streamId].IsEnabled = true;
+            else
+                CMN_LOG_INIT_WARNING << "FBGMulticastPublisher: ignoring unknown stream \""
+                                     << jsonStream.asString() << "\"" << std::endl;
+        }
+    }
+}
+
+void FBGMulticastPublisher::Open()
+{
+    Close();
+
+    std::memset(&m_Destination, 0, sizeof(m_Destination));
+    m_Destination.sin_family = AF_INET;
+    m_Destination.sin_port   = htons(m_Port);
+    if (::inet_pton(AF_INET, m_Group.c_str(), &m_Destination.sin_addr) != 1 || !IN_MULTICAST(ntohl(m_Destination.sin_addr.s_addr)))
+        throw std::runtime_error("Invalid multicast group \"" + m_Group + "\"");
+
+    in_addr interfaceAddress;
+    if (::inet_pton(AF_INET, m_Interface.c_str(), &interfaceAddress) != 1)
+        throw std::runtime_error("Invalid multicast interface address \"" + m_Interface + "\"");
+
+    m_Socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (m_Socket < 0)
+        throw std::runtime_error(std::string("Failed to create the multicast socket: ") + std::strerror(errno));
+
+    unsigned char ttl      = (unsigned char) m_TTL;
+    unsigned char loopback = m_Loopback ? 1 : 0;
+    if (
+        ::setsockopt(m_Socket, IPPROTO_IP, IP_MULTICAST_TTL,  &ttl,              sizeof(ttl)) != 0
+        || ::setsockopt(m_Socket, IPPROTO_IP, IP_MULTICAST_LOOP, &loopback,         sizeof(loopback)) != 0
+        || ::setsockopt(m_Socket, IPPROTO_IP, IP_MULTICAST_IF,   &interfaceAddress, sizeof(interfaceAddress)) != 0
+    )
+    {
+        std::string error = std::string("Failed to set up multicast to \"") + m_Group + "\": " + std::strerror(errno);
+        Close();
+        throw std::runtime_error(error);
+    }
+
+    for (Stream& stream : m_Streams)
+        stream.Sequence = 0;
+
+    m_NumSent    = 0;
+    m_NumDropped = 0;
+}
+
+void FBGMulticastPublisher::Close()
+{
+    if (m_Socket >= 0)
+        ::close(m_Socket);
+
+    m_Socket = -1;
+}
+
+bool FBGMulticastPublisher::Push(const FBGStream::StreamId stream, const double time, const double* values, const size_t numValues)
+{
+    if (m_Socket < 0 || stream >= FBGStream::NUM_STREAMS || !m_Streams[stream].IsEnabled)
+        return false;
+
+    // a frame that is not sent leaves a gap in the sequence
+    Stream& output = m_Streams[stream];
+    FBGStream::EncodeFrame(output.Frame, stream, output.Sequence++, time, values, numValues);
+
+    ssize_t sent = ::sendto(
+        m_Socket,
+        output.Frame.data(),
+        output.Frame.size() * sizeof(double),
+        MSG_DONTWAIT,
+        reinterpret_cast<const sockaddr*>(&m_Destination),
+        sizeof(m_Destination)
+    );
+    if (sent < 0)
+    {
+        m_NumDropped++;
+        return false;
+    }
+
+    m_NumSent++;
+    return true;
+}
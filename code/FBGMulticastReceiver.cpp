@@ -0,0 +1,143 @@
+#include "mtsFBGSensor/Streaming/FBGMulticastReceiver.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    const size_t MAX_DATAGRAM_SIZE = 65536;
+
+} // namespace
+
+void FBGMulticastReceiver::Open(const std::string& group, const uint16_t port, const std::string& interfaceAddress)
+{
+    Close();
+
+    ip_mreq membership;
+    if (::inet_pton(AF_INET, group.c_str(), &membership.imr_multiaddr) != 1 || !IN_MULTICAST(ntohl(membership.imr_multiaddr.s_addr)))
+        throw std::runtime_error("Invalid multicast group \"" + group + "\"");
+
+    if (::inet_pton(AF_INET, interfaceAddress.c_str(), &membership.imr_interface) != 1)
+        throw std::runtime_error("Invalid multicast interface address \"" + interfaceAddress + "\"");
+
+    m_Socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (m_Socket < 0)
+        throw std::runtime_error(std::string("Failed to create the multicast socket: ") + std::strerror(errno));
+
+    // several receivers on one host share the port; binding the group filters out other traffic
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(port);
+    address.sin_addr   = membership.imr_multiaddr;
+
+    int reuse = 1;
+    if (
+        ::setsockopt(m_Socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0
+        || ::bind(m_Socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || ::setsockopt(m_Socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0
+    )
+    {
+        std::string error = "Failed to join multicast group \"" + group + "\": " + std::strerror(errno);
+        Close();
+        throw std::runtime_error(error);
+    }
+
+    m_Buffer.resize(MAX_DATAGRAM_SIZE / sizeof(double));
+    ResetStatistics();
+}
+
+void FBGMulticastReceiver::Close()
+{
+    if (m_Socket >= 0)
+        ::close(m_Socket);
+
+    m_Socket = -1;
+}
+
+void FBGMulticastReceiver::ResetStatistics()
+{
+    for (Stream& stream : m_Streams)
+        stream = Stream();
+
+    m_NumInvalid = 0;
+}
+
+bool FBGMulticastReceiver::Receive(FBGStream::FrameHeader& header, std::vector<double>& values, const double timeout)
+{
+    if (m_Socket < 0)
+        throw std::runtime_error("The multicast receiver is not open");
+
+    while (true)
+    {
+        pollfd pollFD = {m_Socket, POLLIN, 0};
+        int ready = ::poll(&pollFD, 1, timeout < 0 ? -1 : int(timeout * 1000));
+        if (ready == 0)
+            return false;
+
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("Failed to wait for a frame: ") + std::strerror(errno));
+        }
+
+        ssize_t size = ::recv(m_Socket, m_Buffer.data(), m_Buffer.size() * sizeof(double), 0);
+        if (size < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            throw std::runtime_error(std::string("Failed to receive a frame: ") + std::strerror(errno));
+        }
+
+        if (!FBGStream::ParseFrameHeader(reinterpret_cast<const uint8_t*>(m_Buffer.data()), size_t(size), header))
+        {
+            m_NumInvalid++;
+            continue;
+        }
+
+        UpdateSequence(m_Streams[header.Stream], header.Sequence);
+
+        const double* frameValues = m_Buffer.data() + sizeof(FBGStream::FrameHeader) / sizeof(double);
+        values.assign(frameValues, frameValues + header.NumValues);
+        return true;
+    }
+}
+
+void FBGMulticastReceiver::UpdateSequence(Stream& stream, const uint64_t sequence)
+{
+    stream.NumReceived++;
+
+    if (!stream.HasSequence || sequence == stream.NextSequence)
+    {
+        stream.HasSequence  = true;
+        stream.NextSequence = sequence + 1;
+        return;
+    }
+
+    if (sequence > stream.NextSequence)
+    {
+        stream.NumLost      += sequence - stream.NextSequence;
+        stream.NextSequence  = sequence + 1;
+        return;
+    }
+
+    // an older frame: either reordered (it was counted as lost) or a restarted publisher
+    if (sequence == 0 || stream.NextSequence - sequence > m_RestartWindow)
+    {
+        stream.NumRestarts++;
+        stream.NextSequence = sequence + 1;
+        return;
+    }
+
+    stream.NumLate++;
+    if (stream.NumLost > 0)
+        stream.NumLost--;
+}
@@ -0,0 +1,125 @@
+#include "mtsFBGSensor/mtsFBGSensor/FBGSlotMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+void FBGSlotMap::Configure(const Json::Value& jsonSlots)
+{
+    std::vector<FBGSlot> slots;
+    for (Json::Value::ArrayIndex i = 0; i != jsonSlots.size(); i++)
+    {
+        const Json::Value jsonSlot = jsonSlots[i];
+
+        FBGSlot slot;
+        slot.Channel       = jsonSlot["Channel"].asUInt();
+        slot.WavelengthMin = jsonSlot["Window"][0].asDouble();
+        slot.WavelengthMax = jsonSlot["Window"][1].asDouble();
+        slot.Name          = jsonSlot.get(
+            "Name",
+            "CH" + std::to_string(slot.Channel) + "_" + std::to_string(i)
+        ).asString();
+
+        slots.push_back(slot);
+    }
+
+    SetSlots(slots);
+}
+
+void FBGSlotMap::SetSlots(const std::vector<FBGSlot>& slots)
+{
+    std::vector<std::vector<Window>> channelWindows;
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        const FBGSlot& slot = slots[i];
+        if (slot.Channel < 1 || slot.WavelengthMax < slot.WavelengthMin)
+            throw std::invalid_argument("Invalid channel or window for FBG slot \"" + slot.Name + "\"");
+
+        if (channelWindows.size() < slot.Channel)
+            channelWindows.resize(slot.Channel);
+
+        channelWindows[slot.Channel - 1].push_back({slot.WavelengthMin, slot.WavelengthMax, i});
+    }
+
+    for (std::vector<Window>& windows : channelWindows)
+    {
+        std::sort(
+            windows.begin(),
+            windows.end(),
+            [] (const Window& a, const Window& b) { return a.Min < b.Min; }
+        );
+
+        for (size_t i = 1; i < windows.size(); i++)
+            if (windows[i].Min <= windows[i - 1].Max)
+                throw std::invalid_argument(
+                    "FBG slots \"" + slots[windows[i - 1].Slot].Name + "\" and \""
+                    + slots[windows[i].Slot].Name + "\" have overlapping windows"
+                );
+    }
+
+    m_Slots          = slots;
+    m_ChannelWindows = channelWindows;
+}
+
+void FBGSlotMap::Assign(const std::vector<vctDoubleVec>& channelPeaks, vctDoubleVec& slotPeaks, vctBoolVec& slotValid)
+{
+    slotPeaks.SetSize(m_Slots.size());
+    slotValid.SetSize(m_Slots.size());
+    slotPeaks.SetAll(std::numeric_limits<double>::quiet_NaN());
+    slotValid.SetAll(false);
+    m_SlotSources.assign(m_Slots.size(), PeakSource{0, 0});
+
+    m_NumUnassigned = 0;
+    m_NumConflicts  = 0;
+
+    for (size_t channel = 0; channel < channelPeaks.size(); channel++)
+    {
+        const vctDoubleVec& peaks = channelPeaks[channel];
+
+        // instrument peaks arrive sorted; only undetected (NaN) peaks need to be dropped
+        m_SortedPeaks.clear();
+        for (size_t i = 0; i < peaks.size(); i++)
+            if (!std::isnan(peaks[i]))
+                m_SortedPeaks.push_back(std::make_pair(peaks[i], i));
+
+        if (!std::is_sorted(m_SortedPeaks.begin(), m_SortedPeaks.end()))
+            std::sort(m_SortedPeaks.begin(), m_SortedPeaks.end());
+
+        if (channel >= m_ChannelWindows.size())
+        {
+            m_NumUnassigned += m_SortedPeaks.size();
+            continue;
+        }
+
+        const std::vector<Window>& windows = m_ChannelWindows[channel];
+        size_t windowIndex = 0;
+        for (const auto& sortedPeak : m_SortedPeaks)
+        {
+            double peak = sortedPeak.first;
+
+            while (windowIndex < windows.size() && windows[windowIndex].Max < peak)
+                windowIndex++;
+
+            if (windowIndex == windows.size() || peak < windows[windowIndex].Min)
+            {
+                m_NumUnassigned++;
+                continue;
+            }
+
+            const Window& window = windows[windowIndex];
+            if (slotValid[window.Slot])
+            {
+                m_NumConflicts++;
+
+                double center = 0.5 * (window.Min + window.Max);
+                if (std::abs(peak - center) >= std::abs(slotPeaks[window.Slot] - center))
+                    continue;
+            }
+
+            slotPeaks[window.Slot]     = peak;
+            slotValid[window.Slot]     = true;
+            m_SlotSources[window.Slot] = {channel, sortedPeak.second};
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#include "mtsFBGSensor/Streaming/FBGStreamClient.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    const size_t MAX_FRAME_VALUES = 4096;
+
+} // namespace
+
+void FBGStreamClient::Connect(const std::string& socketPath)
+{
+    Close();
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Invalid stream socket path \"" + socketPath + "\"");
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    m_Socket = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (m_Socket < 0 || ::connect(m_Socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        std::string error = "Failed to connect to \"" + socketPath + "\": " + std::strerror(errno);
+        Close();
+        throw std::runtime_error(error);
+    }
+
+    m_Buffer.resize(FBGStream::GetFrameSize(MAX_FRAME_VALUES) / sizeof(double));
+}
+
+void FBGStreamClient::Close()
+{
+    if (m_Socket >= 0)
+        ::close(m_Socket);
+
+    m_Socket = -1;
+}
+
+void FBGStreamClient::Subscribe(const std::vector<FBGStream::Selection>& selections)
+{
+    if (m_Socket < 0)
+        throw std::runtime_error("The stream client is not connected");
+
+    if (selections.size() > FBGStream::MAX_SELECTIONS)
+        throw std::runtime_error("A subscription holds at most " + std::to_string(FBGStream::MAX_SELECTIONS) + " selections");
+
+    FBGStream::SubscriptionHeader header;
+    header.Magic         = FBGStream::SUBSCRIPTION_MAGIC;
+    header.Version       = FBGStream::VERSION;
+    header.NumSelections = uint16_t(selections.size());
+
+    std::vector<uint8_t> request(FBGStream::GetSubscriptionSize(selections.size()));
+    std::memcpy(request.data(), &header, sizeof(header));
+    std::memcpy(request.data() + sizeof(header), selections.data(), selections.size() * sizeof(FBGStream::Selection));
+
+    if (::send(m_Socket, request.data(), request.size(), MSG_NOSIGNAL) < 0)
+        throw std::runtime_error(std::string("Failed to send the subscription: ") + std::strerror(errno));
+}
+
+bool FBGStreamClient::Receive(FBGStream::FrameHeader& header, std::vector<double>& values, const double timeout)
+{
+    if (m_Socket < 0)
+        throw std::runtime_error("The stream client is not connected");
+
+    while (true)
+    {
+        pollfd pollFD = {m_Socket, POLLIN, 0};
+        int ready = ::poll(&pollFD, 1, timeout < 0 ? -1 : int(timeout * 1000));
+        if (ready == 0)
+            return false;
+
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("Failed to wait for a frame: ") + std::strerror(errno));
+        }
+
+        ssize_t size = ::recv(m_Socket, m_Buffer.data(), m_Buffer.size() * sizeof(double), 0);
+        if (size == 0)
+        {
+            Close();
+            throw std::runtime_error("The stream server closed the connection");
+        }
+        if (size < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            throw std::runtime_error(std::string("Failed to receive a frame: ") + std::strerror(errno));
+        }
+
+        // frames of another version are skipped
+        if (!FBGStream::ParseFrameHeader(reinterpret_cast<const uint8_t*>(m_Buffer.data()), size_t(size), header))
+            continue;
+
+        const double* frameValues = m_Buffer.data() + sizeof(FBGStream::FrameHeader) / sizeof(double);
+        values.assign(frameValues, frameValues + header.NumValues);
+        return true;
+    }
+}
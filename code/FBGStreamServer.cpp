@@ -0,0 +1,375 @@
+#include "mtsFBGSensor/Streaming/FBGStreamServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    const int POLL_TIMEOUT = 100; // [ms] bounds how long Stop() waits on an idle server
+
+    std::string SystemError(const std::string& what, const std::string& path)
+    {
+        return what + " \"" + path + "\": " + std::strerror(errno);
+    }
+
+} // namespace
+
+FBGStreamServer::~FBGStreamServer()
+{
+    Stop();
+
+    if (m_WakeEvent >= 0)
+        ::close(m_WakeEvent);
+}
+
+void FBGStreamServer::Configure(const Json::Value& jsonConfig)
+{
+    if (jsonConfig.isMember("Socket_Path"))
+        m_SocketPath = jsonConfig["Socket_Path"].asString();
+
+    if (jsonConfig.isMember("Queue_Size"))
+        m_QueueSize = std::max(jsonConfig["Queue_Size"].asUInt(), 1u);
+
+    if (jsonConfig.isMember("Max_Clients"))
+        m_MaxClients = jsonConfig["Max_Clients"].asUInt();
+
+    if (jsonConfig.isMember("Send_Buffer_Size"))
+        m_SendBufferSize = jsonConfig["Send_Buffer_Size"].asInt();
+}
+
+void FBGStreamServer::Start()
+{
+    Stop();
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (m_SocketPath.empty() || m_SocketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Invalid stream socket path \"" + m_SocketPath + "\"");
+    std::strncpy(address.sun_path, m_SocketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    // message boundaries are kept, so every receive is one whole frame
+    m_ListenSocket = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_ListenSocket < 0)
+        throw std::runtime_error(SystemError("Failed to create socket", m_SocketPath));
+
+    // a socket file left behind by an earlier run
+    ::unlink(m_SocketPath.c_str());
+
+    if (
+        ::bind(m_ListenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(m_ListenSocket, int(m_MaxClients)) != 0
+    )
+    {
+        std::string error = SystemError("Failed to listen on", m_SocketPath);
+        Stop();
+        throw std::runtime_error(error);
+    }
+
+    // kept open until destruction, a producer may still signal it after Stop()
+    if (m_WakeEvent < 0)
+        m_WakeEvent = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_WakeEvent < 0)
+    {
+        std::string error = SystemError("Failed to create the wake event of", m_SocketPath);
+        Stop();
+        throw std::runtime_error(error);
+    }
+
+    for (Stream& stream : m_Streams)
+    {
+        stream.Slots.assign(m_QueueSize, std::vector<double>());
+        stream.Head     = 0;
+        stream.Tail     = 0;
+        stream.Sequence = 0;
+    }
+
+    m_RequestBuffer.resize(FBGStream::GetSubscriptionSize(FBGStream::MAX_SELECTIONS));
+
+    m_NumSent    = 0;
+    m_NumDropped = 0;
+    m_NumSkipped = 0;
+    m_Stop       = false;
+    m_IsRunning  = true;
+
+    m_Server = std::thread(&FBGStreamServer::ServerLoop, this);
+}
+
+void FBGStreamServer::Stop()
+{
+    m_IsRunning = false;
+
+    if (m_Server.joinable())
+    {
+        m_Stop = true;
+
+        uint64_t wake = 1;
+        if (::write(m_WakeEvent, &wake, sizeof(wake)) < 0)
+        {
+            // the server still wakes up within POLL_TIMEOUT
+        }
+        m_Server.join();
+    }
+
+    for (Client& client : m_Clients)
+        CloseClient(client);
+    m_Clients.clear();
+    m_NumClients = 0;
+
+    if (m_ListenSocket >= 0)
+    {
+        ::close(m_ListenSocket);
+        ::unlink(m_SocketPath.c_str());
+    }
+    m_ListenSocket = -1;
+}
+
+bool FBGStreamServer::Push(const FBGStream::StreamId stream, const double time, const double* values, const size_t numValues)
+{
+    if (!m_IsRunning || stream >= FBGStream::NUM_STREAMS)
+        return false;
+
+    Stream& queue    = m_Streams[stream];
+    uint64_t sequence = queue.Sequence++; // a dropped frame leaves a gap in the sequence
+
+    size_t head = queue.Head.load(std::memory_order_relaxed);
+    size_t tail = queue.Tail.load(std::memory_order_acquire);
+    if (head - tail >= queue.Slots.size())
+    {
+        m_NumDropped++;
+        return false;
+    }
+
+    FBGStream::EncodeFrame(queue.Slots[head % queue.Slots.size()], stream, sequence, time, values, numValues);
+
+    queue.Head.store(head + 1, std::memory_order_release);
+
+    uint64_t wake = 1;
+    if (::write(m_WakeEvent, &wake, sizeof(wake)) < 0)
+    {
+        // the counter saturating only means the server is already due to wake up
+    }
+
+    return true;
+}
+
+void FBGStreamServer::ServerLoop()
+{
+    std::vector<pollfd> pollFDs;
+
+    while (!m_Stop)
+    {
+        pollFDs.clear();
+        pollFDs.push_back({m_WakeEvent,    POLLIN, 0});
+        pollFDs.push_back({m_ListenSocket, POLLIN, 0});
+        for (const Client& client : m_Clients)
+            pollFDs.push_back({client.Socket, POLLIN, 0});
+
+        if (::poll(pollFDs.data(), pollFDs.size(), POLL_TIMEOUT) < 0 && errno != EINTR)
+            break;
+
+        if (pollFDs[0].revents & POLLIN)
+        {
+            uint64_t wakeCount;
+            if (::read(m_WakeEvent, &wakeCount, sizeof(wakeCount)) < 0)
+            {
+                // nothing to reset
+            }
+        }
+
+        for (size_t i = 0; i < m_Clients.size(); i++)
+        {
+            if (pollFDs[i + 2].revents & POLLIN)
+                ReceiveSubscription(m_Clients[i]);
+
+            else if (pollFDs[i + 2].revents & (POLLHUP | POLLERR))
+                CloseClient(m_Clients[i]);
+        }
+
+        if (pollFDs[1].revents & POLLIN)
+            AcceptClients();
+
+        for (size_t streamId = 0; streamId < FBGStream::NUM_STREAMS; streamId++)
+            SendFrames(FBGStream::StreamId(streamId));
+
+        m_Clients.erase(
+            std::remove_if(m_Clients.begin(), m_Clients.end(), [] (const Client& client) { return client.Socket < 0; }),
+            m_Clients.end()
+        );
+        m_NumClients = m_Clients.size();
+    }
+}
+
+void FBGStreamServer::AcceptClients()
+{
+    while (true)
+    {
+        int socket = ::accept4(m_ListenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket < 0)
+            return;
+
+        if (m_Clients.size() >= m_MaxClients)
+        {
+            ::close(socket);
+            continue;
+        }
+
+        if (
+            m_SendBufferSize > 0
+            && ::setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &m_SendBufferSize, sizeof(m_SendBufferSize)) != 0
+        )
+        {
+            // the client keeps the system's default buffer
+        }
+
+        Client client;
+        client.Socket = socket;
+        for (size_t streamId = 0; streamId < FBGStream::NUM_STREAMS; streamId++)
+        {
+            client.Decimation[streamId]   = 1;
+            client.IsSubscribed[streamId] = true;
+            client.NumFrames[streamId]    = 0;
+        }
+        client.IOVectors.reserve(FBGStream::MAX_SELECTIONS + 1);
+        m_Clients.push_back(client);
+    }
+}
+
+void FBGStreamServer::ReceiveSubscription(Client& client)
+{
+    ssize_t size = ::recv(client.Socket, m_RequestBuffer.data(), m_RequestBuffer.size(), MSG_DONTWAIT);
+    if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return;
+
+    if (size <= 0)
+    {
+        CloseClient(client);
+        return;
+    }
+
+    // an invalid request leaves the current subscription in place
+    FBGStream::SubscriptionHeader     header;
+    std::vector<FBGStream::Selection> selections;
+    if (!FBGStream::ParseSubscription(m_RequestBuffer.data(), size_t(size), header, selections))
+        return;
+
+    client.IsFiltered = !selections.empty();
+    client.Selections.swap(selections);
+    for (size_t streamId = 0; streamId < FBGStream::NUM_STREAMS; streamId++)
+    {
+        client.Decimation[streamId]   = 1;
+        client.IsSubscribed[streamId] = !client.IsFiltered;
+        client.NumFrames[streamId]    = 0;
+    }
+
+    for (const FBGStream::Selection& selection : client.Selections)
+    {
+        if (client.IsSubscribed[selection.Stream])
+            continue;
+
+        client.IsSubscribed[selection.Stream] = true;
+        client.Decimation[selection.Stream]   = std::max<uint16_t>(selection.Decimation, 1);
+    }
+}
+
+void FBGStreamServer::SendFrames(const FBGStream::StreamId streamId)
+{
+    Stream& stream = m_Streams[streamId];
+
+    size_t tail = stream.Tail.load(std::memory_order_relaxed);
+    size_t head = stream.Head.load(std::memory_order_acquire);
+
+    for (; tail != head; tail++)
+    {
+        const std::vector<double>& slot = stream.Slots[tail % stream.Slots.size()];
+
+        for (Client& client : m_Clients)
+        {
+            if (client.Socket < 0 || !client.IsSubscribed[streamId])
+                continue;
+
+            if (client.NumFrames[streamId]++ % client.Decimation[streamId] != 0)
+                continue;
+
+            if (!GatherFrame(client, slot))
+                continue;
+
+            msghdr message;
+            std::memset(&message, 0, sizeof(message));
+            message.msg_iov    = client.IOVectors.data();
+            message.msg_iovlen = client.IOVectors.size();
+
+            if (::sendmsg(client.Socket, &message, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0)
+                continue;
+
+            // a client that is not keeping up misses frames rather than delaying the others
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                client.NumSkipped++;
+                m_NumSkipped++;
+            }
+            else
+                CloseClient(client);
+        }
+
+        m_NumSent++;
+    }
+
+    stream.Tail.store(tail, std::memory_order_release);
+}
+
+bool FBGStreamServer::GatherFrame(Client& client, const std::vector<double>& slot)
+{
+    FBGStream::FrameHeader header;
+    std::memcpy(&header, slot.data(), sizeof(header));
+
+    // iovec does not take const data, sendmsg() only reads it
+    double* values = const_cast<double*>(slot.data()) + sizeof(header) / sizeof(double);
+
+    client.Header = header;
+    client.IOVectors.clear();
+    client.IOVectors.push_back({&client.Header, sizeof(client.Header)});
+
+    if (!client.IsFiltered)
+    {
+        client.IOVectors.push_back({values, header.NumValues * sizeof(double)});
+        return true;
+    }
+
+    size_t numSelected = 0;
+    for (const FBGStream::Selection& selection : client.Selections)
+    {
+        if (selection.Stream != header.Stream || selection.First >= header.NumValues)
+            continue;
+
+        size_t count = header.NumValues - selection.First;
+        if (selection.Count > 0)
+            count = std::min<size_t>(count, selection.Count);
+
+        client.IOVectors.push_back({values + selection.First, count * sizeof(double)});
+        numSelected += count;
+    }
+
+    // none of the selected values are in this frame
+    if (numSelected == 0)
+        return false;
+
+    client.Header.NumValues = uint32_t(numSelected);
+    return true;
+}
+
+void FBGStreamServer::CloseClient(Client& client)
+{
+    if (client.Socket >= 0)
+        ::close(client.Socket);
+
+    client.Socket = -1;
+}
@@ -0,0 +1,477 @@
+#include "mtsFBGSensor/SensorFilters/FilterBank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <cisstCommon/cmnLogger.h>
+
+#include "mtsFBGSensor/Utilities/SIMDLane.h"
+
+namespace
+{
+    std::string ToUpper(std::string text)
+    {
+        std::transform(
+            text.begin(),
+            text.end(),
+            text.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+        return text;
+    }
+
+    // single sections of the RBJ audio EQ cookbook
+    enum class Response {
+        LOWPASS,
+        HIGHPASS,
+        BANDPASS,
+        NOTCH,
+    };
+
+    FilterBank::Biquad DesignSection(const Response response, const double frequency, const double Q, const double sampleRate)
+    {
+        double w0    = 2.0 * M_PI * frequency / sampleRate;
+        double cosW0 = std::cos(w0);
+        double alpha = std::sin(w0) / (2.0 * Q);
+        double a0    = 1.0 + alpha;
+
+        FilterBank::Biquad section;
+        switch (response)
+        {
+            case Response::LOWPASS:
+                section.B0 = 0.5 * (1.0 - cosW0);
+                section.B1 = 1.0 - cosW0;
+                section.B2 = section.B0;
+                break;
+
+            case Response::HIGHPASS:
+                section.B0 = 0.5 * (1.0 + cosW0);
+                section.B1 = -(1.0 + cosW0);
+                section.B2 = section.B0;
+                break;
+
+            case Response::BANDPASS:
+                section.B0 = alpha;
+                section.B1 = 0.0;
+                section.B2 = -alpha;
+                break;
+
+            case Response::NOTCH:
+                section.B0 = 1.0;
+                section.B1 = -2.0 * cosW0;
+                section.B2 = 1.0;
+                break;
+        }
+        section.A1 = -2.0 * cosW0;
+        section.A2 = 1.0 - alpha;
+
+        section.B0 /= a0;
+        section.B1 /= a0;
+        section.B2 /= a0;
+        section.A1 /= a0;
+        section.A2 /= a0;
+        return section;
+    }
+
+} // namespace
+
+std::vector<FilterBank::Biquad> FilterBank::DesignButterworth(const size_t order, const double cutoff, const double sampleRate,
+                                                              const bool isHighpass)
+{
+    std::vector<Biquad> sections;
+
+    double K = std::tan(M_PI * cutoff / sampleRate);
+    for (size_t k = 0; k < order / 2; k++)
+    {
+        double Q    = 1.0 / (2.0 * std::sin(M_PI * (2.0 * k + 1.0) / (2.0 * order)));
+        double norm = 1.0 / (1.0 + K / Q + K * K);
+
+        Biquad section;
+        section.B0 = isHighpass ? norm : K * K * norm;
+        section.B1 = isHighpass ? -2.0 * section.B0 : 2.0 * section.B0;
+        section.B2 = section.B0;
+        section.A1 = 2.0 * (K * K - 1.0) * norm;
+        section.A2 = (1.0 - K / Q + K * K) * norm;
+        sections.push_back(section);
+    }
+
+    return sections;
+}
+
+bool FilterBank::Configure(const Json::Value& jsonConfig)
+{
+    m_Enabled = jsonConfig.get("Enabled", true).asBool();
+    m_Stages.clear();
+
+    if (jsonConfig.isMember("Sample_Rate") && jsonConfig["Sample_Rate"].asDouble() > 0)
+        m_SampleRate = jsonConfig["Sample_Rate"].asDouble();
+
+    const Json::Value& jsonStages = jsonConfig["Stages"];
+    for (Json::Value::ArrayIndex i = 0; i < jsonStages.size(); i++)
+    {
+        if (!AddStage(jsonStages[i]))
+        {
+            CMN_LOG_INIT_ERROR << "FilterBank: invalid stage " << i << " " << jsonStages[i]
+                               << ", disabling the filters" << std::endl;
+            m_Enabled = false;
+            m_Stages.clear();
+            return false;
+        }
+    }
+
+    if (m_Stages.empty())
+        m_Enabled = false;
+
+    SetNumberOfChannels(m_NumChannels);
+    return true;
+}
+
+bool FilterBank::AddStage(const Json::Value& jsonStage)
+{
+    std::string type      = ToUpper(jsonStage.get("Type", "").asString());
+    double      frequency = jsonStage.get("Frequency", 0.0).asDouble();
+    bool        isDesign  = type == "LOWPASS" || type == "HIGHPASS" || type == "BANDPASS" || type == "NOTCH";
+
+    if (isDesign && !(frequency > 0 && frequency < 0.5 * m_SampleRate))
+        return false;
+
+    Stage stage;
+    std::ostringstream description;
+
+    if (type == "LOWPASS" || type == "HIGHPASS")
+    {
+        bool isHighpass = type == "HIGHPASS";
+        description << (isHighpass ? "Highpass (" : "Lowpass (");
+
+        if (jsonStage.isMember("Q"))
+        {
+            double Q = jsonStage["Q"].asDouble();
+            if (!(Q > 0))
+                return false;
+
+            stage.Sections.push_back(DesignSection(isHighpass ? Response::HIGHPASS : Response::LOWPASS, frequency, Q, m_SampleRate));
+            description << "Q " << Q;
+        }
+        else
+        {
+            // odd orders are rounded up to whole biquads
+            size_t order = std::max(jsonStage.get("Order", 2).asUInt(), 1u);
+            order        = std::min<size_t>(order + (order % 2), 8);
+
+            stage.Sections = DesignButterworth(order, frequency, m_SampleRate, isHighpass);
+            description << "order " << order;
+        }
+        description << ", " << frequency << " Hz)";
+    }
+
+    else if (type == "BANDPASS")
+    {
+        double Q = jsonStage.get("Q", M_SQRT1_2).asDouble();
+        if (!(Q > 0))
+            return false;
+
+        stage.Sections.push_back(DesignSection(Response::BANDPASS, frequency, Q, m_SampleRate));
+        description << "Bandpass (" << frequency << " Hz, Q " << Q << ")";
+    }
+
+    else if (type == "NOTCH")
+    {
+        size_t numHarmonics = std::max(jsonStage.get("Harmonics", 1).asUInt(), 1u);
+        double bandwidth    = jsonStage.get("Bandwidth", 0.0).asDouble();
+        double Q            = jsonStage.get("Q", 1.0).asDouble();
+        if (jsonStage.isMember("Bandwidth") ? !(bandwidth > 0) : !(Q > 0))
+            return false;
+
+        // the same bandwidth around every harmonic
+        for (size_t h = 1; h <= numHarmonics && h * frequency < 0.5 * m_SampleRate; h++)
+        {
+            double harmonicQ = bandwidth > 0 ? h * frequency / bandwidth : Q;
+            stage.Sections.push_back(DesignSection(Response::NOTCH, h * frequency, harmonicQ, m_SampleRate));
+        }
+
+        description << "Notch (" << frequency << " Hz";
+        if (stage.Sections.size() > 1)
+            description << " x" << stage.Sections.size();
+        description << ")";
+    }
+
+    else if (type == "BIQUAD")
+    {
+        const Json::Value& jsonSections = jsonStage["Sections"];
+        for (Json::Value::ArrayIndex i = 0; i < jsonSections.size(); i++)
+        {
+            const Json::Value& jsonSection = jsonSections[i];
+            if (jsonSection.size() != 5)
+                return false;
+
+            Biquad section;
+            section.B0 = jsonSection[0].asDouble();
+            section.B1 = jsonSection[1].asDouble();
+            section.B2 = jsonSection[2].asDouble();
+            section.A1 = jsonSection[3].asDouble();
+            section.A2 = jsonSection[4].asDouble();
+            stage.Sections.push_back(section);
+        }
+
+        if (stage.Sections.empty())
+            return false;
+
+        description << "Biquad (" << stage.Sections.size() << " sections)";
+    }
+
+    else if (type == "FIR")
+    {
+        stage.Kind = Type::FIR;
+
+        const Json::Value& jsonTaps = jsonStage["Taps"];
+        for (Json::Value::ArrayIndex i = 0; i < jsonTaps.size(); i++)
+            stage.Taps.push_back(jsonTaps[i].asDouble());
+
+        if (stage.Taps.empty())
+            return false;
+
+        description << "FIR (" << stage.Taps.size() << " taps)";
+    }
+
+    else if (type == "MOVING_AVERAGE")
+    {
+        stage.Kind       = Type::MOVING_AVERAGE;
+        stage.NumSamples = std::max(jsonStage.get("Num_Samples", 1).asUInt(), 1u);
+
+        description << "Moving average (" << stage.NumSamples << " samples)";
+    }
+
+    else
+        return false;
+
+    stage.Description = description.str();
+    m_Stages.push_back(stage);
+    return true;
+}
+
+std::string FilterBank::GetDescription() const
+{
+    std::string description;
+    for (const Stage& stage : m_Stages)
+        description += (description.empty() ? "" : " > ") + stage.Description;
+
+    return description;
+}
+
+void FilterBank::SetNumberOfChannels(const size_t numChannels)
+{
+    m_NumChannels = numChannels;
+    m_Stride      = SIMDLane::PaddedSize(numChannels);
+
+    // rows of state per stage: z1 and z2 per section, a doubled FIR history, a moving average
+    // ring and its sum
+    size_t numRows = 0;
+    for (Stage& stage : m_Stages)
+    {
+        stage.StateOffset = numRows * m_Stride;
+        switch (stage.Kind)
+        {
+            case Type::BIQUAD:
+                numRows += 2 * stage.Sections.size();
+                break;
+
+            case Type::FIR:
+                numRows += 2 * stage.Taps.size();
+                break;
+
+            case Type::MOVING_AVERAGE:
+                numRows += stage.NumSamples + 1;
+                break;
+        }
+    }
+
+    m_States.assign(numRows * m_Stride, 0.0);
+    m_Work.assign(m_Stride, 0.0);
+    Reset();
+}
+
+void FilterBank::Reset()
+{
+    m_IsPrimed = false;
+}
+
+void FilterBank::Process(vctDoubleVec& samples)
+{
+    if (samples.size() != m_NumChannels)
+        SetNumberOfChannels(samples.size());
+
+    Process(samples.Pointer(), samples.Pointer());
+}
+
+void FilterBank::Process(const double* input, double* output)
+{
+    if (!m_IsPrimed)
+    {
+        // every stage starts in the steady state of the first sample, passed down the cascade
+        std::copy(input, input + m_NumChannels, m_Work.begin());
+        for (Stage& stage : m_Stages)
+            PrimeStage(stage, m_Work.data());
+
+        m_IsPrimed = true;
+    }
+
+    std::copy(input, input + m_NumChannels, m_Work.begin());
+    for (Stage& stage : m_Stages)
+    {
+        switch (stage.Kind)
+        {
+            case Type::BIQUAD:
+                ProcessBiquad(stage, m_Work.data());
+                break;
+
+            case Type::FIR:
+                ProcessFIR(stage, m_Work.data());
+                break;
+
+            case Type::MOVING_AVERAGE:
+                ProcessMovingAverage(stage, m_Work.data());
+                break;
+        }
+    }
+    std::copy(m_Work.begin(), m_Work.begin() + m_NumChannels, output);
+}
+
+void FilterBank::PrimeStage(Stage& stage, double* sample)
+{
+    double* states = m_States.data() + stage.StateOffset;
+
+    switch (stage.Kind)
+    {
+        case Type::BIQUAD:
+            for (size_t s = 0; s < stage.Sections.size(); s++)
+            {
+                const Biquad& section = stage.Sections[s];
+                double*       z1      = states + 2 * s * m_Stride;
+                double*       z2      = z1 + m_Stride;
+
+                // DC gain; a section with a pole at DC has no steady state and starts at rest
+                double denominator = 1.0 + section.A1 + section.A2;
+                double gain        = std::abs(denominator) > 1e-12 ? (section.B0 + section.B1 + section.B2) / denominator : 0.0;
+                for (size_t c = 0; c < m_Stride; c++)
+                {
+                    double x = sample[c];
+                    double y = gain * x;
+                    z2[c]     = section.B2 * x - section.A2 * y;
+                    z1[c]     = section.B1 * x - section.A1 * y + z2[c];
+                    sample[c] = y;
+                }
+            }
+            break;
+
+        case Type::FIR:
+        {
+            double gain = 0.0;
+            for (double tap : stage.Taps)
+                gain += tap;
+
+            for (size_t row = 0; row < 2 * stage.Taps.size(); row++)
+                std::copy(sample, sample + m_Stride, states + row * m_Stride);
+
+            for (size_t c = 0; c < m_Stride; c++)
+                sample[c] *= gain;
+
+            stage.Position = 0;
+            break;
+        }
+
+        case Type::MOVING_AVERAGE:
+        {
+            double* sum = states;
+            for (size_t row = 1; row <= stage.NumSamples; row++)
+                std::copy(sample, sample + m_Stride, states + row * m_Stride);
+
+            for (size_t c = 0; c < m_Stride; c++)
+                sum[c] = double(stage.NumSamples) * sample[c];
+
+            stage.Position = 0;
+            break;
+        }
+    }
+}
+
+void FilterBank::ProcessBiquad(Stage& stage, double* samples)
+{
+    // transposed direct form II, every section over all channels
+    double* states = m_States.data() + stage.StateOffset;
+    for (size_t s = 0; s < stage.Sections.size(); s++)
+    {
+        const Biquad& section = stage.Sections[s];
+        double*       z1      = states + 2 * s * m_Stride;
+        double*       z2      = z1 + m_Stride;
+
+        const SIMDLane::Lane B0 = SIMDLane::Set(section.B0);
+        const SIMDLane::Lane B1 = SIMDLane::Set(section.B1);
+        const SIMDLane::Lane B2 = SIMDLane::Set(section.B2);
+        const SIMDLane::Lane A1 = SIMDLane::Set(-section.A1);
+        const SIMDLane::Lane A2 = SIMDLane::Set(-section.A2);
+
+        for (size_t c = 0; c < m_Stride; c += SIMDLane::WIDTH)
+        {
+            SIMDLane::Lane x = SIMDLane::Load(samples + c);
+            SIMDLane::Lane y = SIMDLane::MulAdd(B0, x, SIMDLane::Load(z1 + c));
+            SIMDLane::Store(z1 + c, SIMDLane::MulAdd(A1, y, SIMDLane::MulAdd(B1, x, SIMDLane::Load(z2 + c))));
+            SIMDLane::Store(z2 + c, SIMDLane::MulAdd(A2, y, SIMDLane::Mul(B2, x)));
+            SIMDLane::Store(samples + c, y);
+        }
+    }
+}
+
+void FilterBank::ProcessFIR(Stage& stage, double* samples)
+{
+    // the history is stored twice so the newest N samples are always N contiguous rows:
+    // row (Position + k) holds x[n - k]
+    size_t        numTaps = stage.Taps.size();
+    const double* taps    = stage.Taps.data();
+    double*       history = m_States.data() + stage.StateOffset;
+
+    stage.Position = (stage.Position + numTaps - 1) % numTaps;
+    std::copy(samples, samples + m_Stride, history + stage.Position * m_Stride);
+    std::copy(samples, samples + m_Stride, history + (stage.Position + numTaps) * m_Stride);
+
+    const double* newest = history + stage.Position * m_Stride;
+    for (size_t c = 0; c < m_Stride; c += SIMDLane::WIDTH)
+    {
+        SIMDLane::Lane sum = SIMDLane::Set(0.0);
+        for (size_t k = 0; k < numTaps; k++)
+            sum = SIMDLane::MulAdd(SIMDLane::Set(taps[k]), SIMDLane::Load(newest + k * m_Stride + c), sum);
+
+        SIMDLane::Store(samples + c, sum);
+    }
+}
+
+void FilterBank::ProcessMovingAverage(Stage& stage, double* samples)
+{
+    // the running sum in the first row, the ring of the last samples after it
+    double*    sum    = m_States.data() + stage.StateOffset;
+    double*    oldest = sum + (stage.Position + 1) * m_Stride;
+    const SIMDLane::Lane scale  = SIMDLane::Set(1.0 / double(stage.NumSamples));
+
+    for (size_t c = 0; c < m_Stride; c += SIMDLane::WIDTH)
+    {
+        SIMDLane::Lane x = SIMDLane::Load(samples + c);
+        SIMDLane::Lane s = SIMDLane::Add(SIMDLane::Load(sum + c), SIMDLane::Sub(x, SIMDLane::Load(oldest + c)));
+        SIMDLane::Store(oldest + c, x);
+        SIMDLane::Store(sum + c, s);
+        SIMDLane::Store(samples + c, SIMDLane::Mul(s, scale));
+    }
+
+    // the running sum is rebuilt once per window so rounding errors do not accumulate
+    if (++stage.Position < stage.NumSamples)
+        return;
+
+    stage.Position = 0;
+    for (size_t c = 0; c < m_Stride; c += SIMDLane::WIDTH)
+    {
+        SIMDLane::Lane s = SIMDLane::Set(0.0);
+        for (size_t row = 1; row <= stage.NumSamples; row++)
+            s = SIMDLane::Add(s, SIMDLane::Load(sum + row * m_Stride + c));
+
+        SIMDLane::Store(sum + c, s);
+    }
+}
@@ -0,0 +1,213 @@
+#include "mtsFBGSensor/SensorFilters/HampelFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <cisstCommon/cmnLogger.h>
+
+namespace
+{
+    // MAD of Gaussian noise x 1.4826 = its standard deviation
+    const double MAD_SCALE = 1.4826;
+
+} // namespace
+
+void HampelFilter::Configure(const Json::Value& jsonConfig)
+{
+    m_Enabled = jsonConfig.get("Enabled", true).asBool();
+
+    if (jsonConfig.isMember("Window"))
+        m_Window = std::max(jsonConfig["Window"].asUInt(), 3u);
+
+    if (jsonConfig.isMember("Threshold"))
+        m_Threshold = jsonConfig["Threshold"].asDouble();
+
+    if (jsonConfig.isMember("Min_Deviation"))
+        m_MinDeviation = jsonConfig["Min_Deviation"].asDouble();
+
+    if (jsonConfig.isMember("Replacement"))
+    {
+        std::string replacement = jsonConfig["Replacement"].asString();
+        std::transform(
+            replacement.begin(),
+            replacement.end(),
+            replacement.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+
+        if (replacement == "MEDIAN")
+            m_Replacement = Replacement::MEDIAN;
+
+        else if (replacement == "PREVIOUS")
+            m_Replacement = Replacement::PREVIOUS;
+
+        else
+            CMN_LOG_INIT_ERROR << "HampelFilter: invalid \"Replacement\" \"" << replacement
+                               << "\", using \"MEDIAN\"" << std::endl;
+    }
+
+    if (!(m_Threshold > 0))
+    {
+        CMN_LOG_INIT_ERROR << "HampelFilter: \"Threshold\" must be positive, disabling the filter" << std::endl;
+        m_Enabled = false;
+    }
+
+    SetNumberOfChannels(m_Channels.size());
+}
+
+void HampelFilter::SetNumberOfChannels(const size_t numChannels)
+{
+    m_Channels.resize(numChannels);
+    for (Channel& channel : m_Channels)
+    {
+        channel.Sorted.Reserve(m_Window);
+        channel.Ring.assign(m_Window, 0.0);
+    }
+    Reset();
+}
+
+void HampelFilter::Reset()
+{
+    for (Channel& channel : m_Channels)
+    {
+        channel.Sorted.Clear();
+        channel.Position = 0;
+        channel.Previous = std::numeric_limits<double>::quiet_NaN();
+    }
+    m_NumOutliers = 0;
+}
+
+double HampelFilter::Median(const Channel& channel)
+{
+    size_t size = channel.Sorted.Size();
+    if (size % 2 == 1)
+        return channel.Sorted.Select(size / 2);
+
+    return 0.5 * (channel.Sorted.Select(size / 2 - 1) + channel.Sorted.Select(size / 2));
+}
+
+double HampelFilter::MedianAbsoluteDeviation(const Channel& channel, const double median)
+{
+    // the deviations are two sorted sequences, outward from the middle of the window:
+    // below[i] = median - x(lower - i) and above[j] = x(lower + 1 + j) - median
+    const OrderStatisticTreap<double>& sorted = channel.Sorted;
+    size_t size     = sorted.Size();
+    size_t lower    = (size - 1) / 2;
+    size_t numBelow = lower + 1;
+    size_t numAbove = size - numBelow;
+
+    auto below = [&] (const size_t i) { return median - sorted.Select(lower - i); };
+    auto above = [&] (const size_t j) { return sorted.Select(lower + 1 + j) - median; };
+
+    // k-th smallest deviation: the split of the k + 1 smallest between the sequences
+    auto select = [&] (const size_t k)
+    {
+        size_t count = k + 1;
+        size_t first = count > numAbove ? count - numAbove : 0;
+        size_t last  = std::min(count, numBelow);
+        while (first < last)
+        {
+            size_t i = (first + last) / 2;
+            if (below(i) < above(count - i - 1))
+                first = i + 1;
+            else
+                last = i;
+        }
+
+        size_t i = first;
+        size_t j = count - first;
+        double deviation = -std::numeric_limits<double>::infinity();
+        if (i > 0)
+            deviation = std::max(deviation, below(i - 1));
+        if (j > 0)
+            deviation = std::max(deviation, above(j - 1));
+        return deviation;
+    };
+
+    if (size % 2 == 1)
+        return select(size / 2);
+
+    return 0.5 * (select(size / 2 - 1) + select(size / 2));
+}
+
+void HampelFilter::MedianAbsoluteDeviationBounds(const Channel& channel, const double median, double& lower, double& upper)
+{
+    // upper: the c = n/2 + 1 samples from index a all deviate by at most the larger distance of
+    // s[a] and s[a + c - 1] from the median, so the middle deviations do too;
+    // lower: fewer than k = (n - 1)/2 + 1 samples lie strictly between s[a'] and s[a' + k], so the
+    // k-th smallest deviation is at least the smaller distance of those two from the median
+    const OrderStatisticTreap<double>& sorted = channel.Sorted;
+    size_t size   = sorted.Size();
+    size_t middle = (size - 1) / 2;
+
+    size_t count = size / 2 + 1;
+    size_t first = (size - count) / 2;
+    upper = std::max(median - sorted.Select(first), sorted.Select(first + count - 1) - median);
+
+    first = middle - (middle + 1) / 2;
+    lower = std::min(median - sorted.Select(first), sorted.Select(first + middle + 1) - median);
+}
+
+double HampelFilter::GetMedian(const size_t channel) const
+{
+    if (channel >= m_Channels.size() || m_Channels[channel].Sorted.Size() < m_Window)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    return Median(m_Channels[channel]);
+}
+
+double HampelFilter::GetMedianAbsoluteDeviation(const size_t channel) const
+{
+    if (channel >= m_Channels.size() || m_Channels[channel].Sorted.Size() < m_Window)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    return MedianAbsoluteDeviation(m_Channels[channel], Median(m_Channels[channel]));
+}
+
+size_t HampelFilter::Process(vctDoubleVec& samples)
+{
+    if (samples.size() != m_Channels.size())
+        SetNumberOfChannels(samples.size());
+
+    size_t numOutliers = 0;
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        Channel& channel = m_Channels[i];
+        double   sample  = samples[i];
+        if (std::isnan(sample))
+            continue;
+
+        // the new sample is tested against the window before it
+        if (channel.Sorted.Size() == m_Window)
+        {
+            double median = Median(channel);
+            double error  = std::abs(sample - median);
+            auto   limit  = [this] (const double deviation) { return std::max(m_Threshold * MAD_SCALE * deviation, m_MinDeviation); };
+
+            // bounds on the MAD from four order statistics settle almost every sample
+            double lowerDeviation, upperDeviation;
+            MedianAbsoluteDeviationBounds(channel, median, lowerDeviation, upperDeviation);
+
+            bool isOutlier = error > limit(upperDeviation);
+            if (!isOutlier && error > limit(lowerDeviation))
+                isOutlier = error > limit(MedianAbsoluteDeviation(channel, median));
+
+            if (isOutlier)
+            {
+                samples[i] = (m_Replacement == Replacement::PREVIOUS && !std::isnan(channel.Previous)) ? channel.Previous : median;
+                numOutliers++;
+            }
+
+            channel.Sorted.Erase(channel.Ring[channel.Position]);
+        }
+
+        channel.Sorted.Insert(sample);
+        channel.Ring[channel.Position] = sample;
+        channel.Position               = (channel.Position + 1) % m_Window;
+        channel.Previous               = samples[i];
+    }
+
+    m_NumOutliers += numOutliers;
+    return numOutliers;
+}
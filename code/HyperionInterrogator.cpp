@@ -1,5 +1,7 @@
 #include "mtsFBGSensor/hyperion/HyperionInterrogator.h"
 
+#include <algorithm>
+
 #include <cisstCommon/cmnLogger.h>
 
 HyperionInterrogator::HyperionInterrogator(const std::string& ipAddress, const unsigned int port) :
@@ -8,6 +10,95 @@ HyperionInterrogator::HyperionInterrogator(const std::string& ipAddress, const u
 
 }
 
+void HyperionInterrogator::Configure(const Json::Value& jsonConfig)
+{
+    if (jsonConfig.isMember("Peak_Source"))
+    {
+        std::string source = jsonConfig["Peak_Source"].asString();
+        std::transform(
+            source.begin(),
+            source.end(),
+            source.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+
+        if (source == "SPECTRUM")
+        {
+            m_SpectrumPeakDetector.reset(new SpectrumPeakDetector());
+            m_SpectrumPeakDetector->Configure(jsonConfig["Peak_Detection"]);
+        }
+
+        else if (source == "INSTRUMENT")
+            m_SpectrumPeakDetector.reset();
+
+        else
+            CMN_LOG_INIT_ERROR << "HyperionInterrogator: invalid \"Peak_Source\" \"" << source
+                               << "\", using \"INSTRUMENT\"" << std::endl;
+    }
+
+    if (jsonConfig.isMember("Spectrum_Recording"))
+    {
+        m_SpectrumRecorder.reset(new SpectrumRecorder());
+        m_SpectrumRecorder->Configure(jsonConfig["Spectrum_Recording"]);
+
+        if (!m_SpectrumRecorder->IsEnabled())
+            m_SpectrumRecorder.reset();
+    }
+
+    if (jsonConfig.isMember("Streaming"))
+    {
+        const Json::Value jsonStreaming = jsonConfig["Streaming"];
+
+        if (jsonStreaming.isMember("Target_Rate"))
+            m_StreamingRate.TargetRate = jsonStreaming["Target_Rate"].asDouble();
+
+        if (jsonStreaming.isMember("Latency_Budget"))
+            m_StreamingRate.LatencyBudget = jsonStreaming["Latency_Budget"].asDouble();
+
+        if (jsonStreaming.isMember("Divider"))
+            m_StreamingRate.Divider = std::max(jsonStreaming["Divider"].asInt(), 1);
+    }
+
+    if (!jsonConfig.isMember("Streaming_Buffer"))
+        return;
+
+    const Json::Value jsonBuffer = jsonConfig["Streaming_Buffer"];
+
+    if (jsonBuffer.isMember("Sample_Period"))
+        m_BufferMonitor.SamplePeriod = jsonBuffer["Sample_Period"].asDouble();
+
+    if (jsonBuffer.isMember("Drain_Threshold"))
+        m_BufferMonitor.DrainThreshold = jsonBuffer["Drain_Threshold"].asInt();
+
+    if (jsonBuffer.isMember("Recover_Threshold"))
+        m_BufferMonitor.RecoverThreshold = std::max(
+            jsonBuffer["Recover_Threshold"].asInt(),
+            m_BufferMonitor.DrainThreshold
+        );
+
+    if (jsonBuffer.isMember("Drain_Mode"))
+    {
+        std::string mode = jsonBuffer["Drain_Mode"].asString();
+        std::transform(
+            mode.begin(),
+            mode.end(),
+            mode.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+
+        if (mode == "NEWEST")
+            m_BufferMonitor.Mode = DrainMode::NEWEST;
+
+        else if (mode == "AVERAGE")
+            m_BufferMonitor.Mode = DrainMode::AVERAGE;
+
+        else
+            CMN_LOG_INIT_ERROR << "HyperionInterrogator: invalid \"Drain_Mode\" \"" << mode
+                               << "\", using \"NEWEST\"" << std::endl;
+    }
+
+}
+
 HyperionInterrogator::~HyperionInterrogator()
 {
     if (!m_Hyperion)
@@ -47,6 +138,14 @@ bool HyperionInterrogator::Disconnect()
         m_Hyperion->close_comm();
     }
 
+    if (m_SpectrumRecorder && m_SpectrumRecorder->IsOpen())
+    {
+        m_SpectrumRecorder->Close();
+        CMN_LOG_INIT_VERBOSE << "HyperionInterrogator: recorded " << m_SpectrumRecorder->GetNumberOfRecordedSweeps()
+                             << " spectra to \"" << m_SpectrumRecorder->GetRecordingDirectory() << "\" ("
+                             << m_SpectrumRecorder->GetNumberOfDroppedSweeps() << " dropped)" << std::endl;
+    }
+
     return true;
 }
 
@@ -64,20 +163,110 @@ int HyperionInterrogator::GetNumberOfChannels() const {
 
 }
 
-vctDoubleVec HyperionInterrogator::GetPeaks() const
+std::vector<vctDoubleVec> HyperionInterrogator::GetChannelPeaks() const
 {
-    hACQPeaks peaksMsg    = GetPeaksInterrogator();
-    auto peaksAll         = peaksMsg.get_all();
-    vctDoubleVec peaksVct = vctDoubleVec(peaksAll.size());
-    
-    for (size_t i = 0; i < peaksVct.size(); i++)
-        peaksVct[i] = peaksAll[i];
+    if (m_SpectrumPeakDetector)
+    {
+        const std::vector<SpectrumPeak>&       peaks   = DetectSpectrumPeaks();
+        const std::vector<SpectrumPeakWindow>& windows = m_SpectrumPeakDetector->GetWindows();
 
-    return peaksVct;
+        // the detector rejects windows without a channel; skipped here as well
+        std::vector<size_t> numChannelPeaks;
+        for (size_t i = 0; i < peaks.size(); i++)
+        {
+            if (windows[i].Channel < 1)
+                continue;
+
+            if (numChannelPeaks.size() < windows[i].Channel)
+                numChannelPeaks.resize(windows[i].Channel, 0);
+            numChannelPeaks[windows[i].Channel - 1]++;
+        }
+
+        std::vector<vctDoubleVec> channelPeaks(numChannelPeaks.size());
+        m_ChannelPeakQuality.resize(numChannelPeaks.size());
+        for (size_t ch = 0; ch < numChannelPeaks.size(); ch++)
+        {
+            channelPeaks[ch].SetSize(numChannelPeaks[ch]);
+            m_ChannelPeakQuality[ch].SetSize(numChannelPeaks[ch], NUM_PEAK_QUALITY_METRICS);
+            numChannelPeaks[ch] = 0;
+        }
+
+        for (size_t i = 0; i < peaks.size(); i++)
+        {
+            if (windows[i].Channel < 1)
+                continue;
+
+            size_t ch  = windows[i].Channel - 1;
+            size_t idx = numChannelPeaks[ch]++;
+
+            channelPeaks[ch][idx] = peaks[i].Wavelength;
+            m_ChannelPeakQuality[ch].Element(idx, PEAK_AMPLITUDE) = peaks[i].Amplitude;
+            m_ChannelPeakQuality[ch].Element(idx, PEAK_FWHM)      = peaks[i].FWHM;
+            m_ChannelPeakQuality[ch].Element(idx, PEAK_SNR)       = peaks[i].SNR;
+            m_ChannelPeakQuality[ch].Element(idx, PEAK_ASYMMETRY) = peaks[i].Asymmetry;
+        }
+
+        return channelPeaks;
+    }
+
+    if (m_isStreaming && m_SpectrumRecorder)
+        RecordQueuedSpectra();
+
+    if (m_isStreaming)
+    {
+        SampleStreamingBuffer();
+
+        if (m_BufferMonitor.IsDraining)
+            return DrainStreamedPeaks();
+    }
+    m_BufferMonitor.NumCollapsed = 1;
+
+    hACQPeaks peaksMsg  = GetPeaksInterrogator();
+    m_PeaksTimestamp    = peaksMsg.timeStamp;
+    m_PeaksSerialNumber = int64_t(peaksMsg.serialNumber);
+
+    return SplitChannelPeaks(peaksMsg);
+}
+
+std::vector<vctDoubleVec> HyperionInterrogator::SplitChannelPeaks(hACQPeaks& peaksMsg)
+{
+    std::vector<vctDoubleVec> channelPeaks(H_MAX_NUM_CHANNELS);
+    for (int chIdx = 1; chIdx <= H_MAX_NUM_CHANNELS; chIdx++)
+    {
+        auto peaksCh = peaksMsg.get_channel(chIdx);
+        vctDoubleVec& peaksVct = channelPeaks[chIdx - 1];
+
+        peaksVct.SetSize(peaksCh.size());
+        for (size_t i = 0; i < peaksVct.size(); i++)
+            peaksVct[i] = peaksCh[i];
+    }
+
+    // trailing channels without peaks are not reported
+    while (!channelPeaks.empty() && channelPeaks.back().size() == 0)
+        channelPeaks.pop_back();
+
+    return channelPeaks;
 }
 
 vctDoubleVec HyperionInterrogator::GetPeaks(const size_t channelId) const
 {
+    if (m_SpectrumPeakDetector)
+    {
+        const std::vector<SpectrumPeak>&       peaks   = DetectSpectrumPeaks();
+        const std::vector<SpectrumPeakWindow>& windows = m_SpectrumPeakDetector->GetWindows();
+
+        std::vector<double> channelPeaks;
+        for (size_t i = 0; i < peaks.size(); i++)
+            if (windows[i].Channel == channelId)
+                channelPeaks.push_back(peaks[i].Wavelength);
+
+        vctDoubleVec peaksVct(channelPeaks.size());
+        for (size_t i = 0; i < peaksVct.size(); i++)
+            peaksVct[i] = channelPeaks[i];
+
+        return peaksVct;
+    }
+
     hACQPeaks peaksMsg    = GetPeaksInterrogator();
     auto peaksAll         = peaksMsg.get_channel(channelId);
     vctDoubleVec peaksVct = vctDoubleVec(peaksAll.size());
@@ -88,6 +277,70 @@ vctDoubleVec HyperionInterrogator::GetPeaks(const size_t channelId) const
     return peaksVct;
 }
 
+const std::vector<SpectrumPeak>& HyperionInterrogator::DetectSpectrumPeaks() const
+{
+    // streams the spectrum when spectrum streaming is enabled, otherwise polls it;
+    // the frame references the receive buffer and is calibrated in place (no per-frame allocation)
+    const hSpectrumFrame& frame = m_Hyperion->read_spectrum_frame(H_SPECTRUM_DOUBLE);
+    const hACQSpectrumHeader* header = &frame.spectrumHeader;
+    m_PeaksTimestamp    = double(header->timeStampInt) + double(header->timeStampFrac) * 1e-9;
+    m_PeaksSerialNumber = int64_t(header->serialNumber);
+
+    // only the channels with a calibration are in the calibrated data
+    size_t numChannels = frame.numCalibratedChannels;
+    if (!m_SpectrumPeakDetector->IsScanSet(header->startWavelength, header->wavelengthIncrement, header->numPoints, numChannels))
+    {
+        if (numChannels < header->numChannels)
+            CMN_LOG_RUN_ERROR << "HyperionInterrogator: calibrations for " << numChannels << " of the spectrum's "
+                              << header->numChannels << " channels, detecting peaks in those only" << std::endl;
+
+        m_SpectrumPeakDetector->SetScan(header->startWavelength, header->wavelengthIncrement, header->numPoints, numChannels);
+    }
+
+    m_SpectrumPeakDetector->Detect(frame.calibratedSpectrumData);
+
+    if (m_SpectrumRecorder)
+        RecordSpectrum(frame);
+
+    return m_SpectrumPeakDetector->GetPeaks();
+}
+
+void HyperionInterrogator::RecordSpectrum(const hSpectrumFrame& frame) const
+{
+    if (!m_SpectrumRecorder->IsEnabled())
+        return;
+
+    const hACQSpectrumHeader& header = frame.spectrumHeader;
+    if (!m_SpectrumRecorder->IsScanSet(header.startWavelength, header.wavelengthIncrement, header.numPoints, header.numChannels))
+    {
+        try
+        {
+            m_SpectrumRecorder->Open(header.startWavelength, header.wavelengthIncrement, header.numPoints, header.numChannels);
+            CMN_LOG_RUN_VERBOSE << "HyperionInterrogator: recording spectra to \""
+                                << m_SpectrumRecorder->GetRecordingDirectory() << "\"" << std::endl;
+        }
+        catch(const std::exception& e)
+        {
+            CMN_LOG_RUN_ERROR << "HyperionInterrogator: spectrum recording disabled: " << e.what() << std::endl;
+            return;
+        }
+    }
+
+    m_SpectrumRecorder->Record(
+        header.serialNumber,
+        double(header.timeStampInt) + double(header.timeStampFrac) * 1e-9,
+        frame.rawSpectrumData
+    );
+}
+
+void HyperionInterrogator::RecordQueuedSpectra() const
+{
+    // spectra streamed next to the instrument's peaks: take whatever arrived without blocking
+    int numQueued = m_Hyperion->get_num_queued_spectra();
+    for (int i = 0; i < numQueued; i++)
+        RecordSpectrum(m_Hyperion->read_spectrum_frame(H_SPECTRUM_RAW));
+}
+
 hACQPeaks HyperionInterrogator::GetPeaksInterrogator() const 
 {
     if (m_isStreaming)
@@ -96,18 +349,187 @@ hACQPeaks HyperionInterrogator::GetPeaksInterrogator() const
     return m_Hyperion->get_peaks();
 }
 
+void HyperionInterrogator::SampleStreamingBuffer() const
+{
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - m_BufferMonitor.LastSampleTime).count() < m_BufferMonitor.SamplePeriod)
+        return;
+
+    m_BufferMonitor.LastSampleTime = now;
+    m_Hyperion->get_peak_streaming_status(m_BufferMonitor.Available);
+
+    // hysteresis between entering and leaving drain mode
+    if (!m_BufferMonitor.IsDraining && m_BufferMonitor.Available < m_BufferMonitor.DrainThreshold)
+    {
+        m_BufferMonitor.IsDraining = true;
+        CMN_LOG_RUN_WARNING << "HyperionInterrogator: peak streaming buffer at "
+                            << m_BufferMonitor.Available << "% available, draining queued samples" << std::endl;
+    }
+    else if (m_BufferMonitor.IsDraining && m_BufferMonitor.Available >= m_BufferMonitor.RecoverThreshold)
+    {
+        m_BufferMonitor.IsDraining = false;
+        CMN_LOG_RUN_VERBOSE << "HyperionInterrogator: peak streaming buffer recovered to "
+                            << m_BufferMonitor.Available << "% available" << std::endl;
+    }
+
+}
+
+std::vector<vctDoubleVec> HyperionInterrogator::DrainStreamedPeaks() const
+{
+    // read every sample that is already queued (at least one) and collapse them into one
+    int numQueued = std::max(m_Hyperion->get_num_queued_peaks(), 1);
+
+    std::vector<vctDoubleVec> channelPeaks;
+    size_t numCollapsed  = 0;
+    double sumTimestamps = 0.0;
+    for (int i = 0; i < numQueued; i++)
+    {
+        hACQPeaks peaksMsg = m_Hyperion->stream_peaks();
+        std::vector<vctDoubleVec> framePeaks = SplitChannelPeaks(peaksMsg);
+        m_PeaksSerialNumber = int64_t(peaksMsg.serialNumber);
+
+        // restart the average whenever the number of peaks of any channel changes
+        bool sameLayout = framePeaks.size() == channelPeaks.size();
+        for (size_t ch = 0; sameLayout && ch < framePeaks.size(); ch++)
+            sameLayout = framePeaks[ch].size() == channelPeaks[ch].size();
+
+        if (m_BufferMonitor.Mode == DrainMode::NEWEST || !sameLayout)
+        {
+            channelPeaks  = framePeaks;
+            numCollapsed  = 1;
+            sumTimestamps = peaksMsg.timeStamp;
+            continue;
+        }
+
+        for (size_t ch = 0; ch < channelPeaks.size(); ch++)
+            channelPeaks[ch].Add(framePeaks[ch]);
+        numCollapsed++;
+        sumTimestamps += peaksMsg.timeStamp;
+    }
+    m_PeaksTimestamp = sumTimestamps / std::max<size_t>(numCollapsed, 1);
+
+    if (numCollapsed > 1)
+        for (vctDoubleVec& peaksVct : channelPeaks)
+            peaksVct.Divide(double(numCollapsed));
+
+    m_BufferMonitor.NumCollapsed = numQueued;
+
+    return channelPeaks;
+}
+
 bool HyperionInterrogator::DisableStreamPeaks()
 {
-    m_Hyperion->disable_peak_streaming();
+    if (!m_isStreaming)
+        return true;
+
+    if (IsStreamingSpectrum())
+        m_Hyperion->disable_spectrum_streaming();
+
+    if (!m_SpectrumPeakDetector)
+        m_Hyperion->disable_peak_streaming();
     m_isStreaming = false;
 
     return !GetIsStreaming();
 }
 
+void HyperionInterrogator::SelectStreamingRate()
+{
+    m_StreamingRate.ScanSpeed = m_Hyperion->get_laser_scan_speed();
+
+    // the latency budget bounds the time between two output samples
+    double requiredRate = m_StreamingRate.TargetRate;
+    if (m_StreamingRate.LatencyBudget > 0)
+        requiredRate = std::max(requiredRate, 1.0 / m_StreamingRate.LatencyBudget);
+
+    if (requiredRate > 0)
+    {
+        std::vector<int> scanSpeeds = m_Hyperion->get_available_laser_scan_speeds();
+        std::sort(scanSpeeds.begin(), scanSpeeds.end());
+
+        // slowest scan speed that still meets the rate has the lowest noise
+        int scanSpeed = 0;
+        for (int speed : scanSpeeds)
+        {
+            if (speed >= requiredRate)
+            {
+                scanSpeed = speed;
+                break;
+            }
+        }
+
+        if (scanSpeed == 0 && !scanSpeeds.empty())
+        {
+            scanSpeed = scanSpeeds.back();
+            CMN_LOG_INIT_WARNING << "HyperionInterrogator: no laser scan speed reaches "
+                                 << requiredRate << " Hz, using the fastest (" << scanSpeed << " Hz)" << std::endl;
+        }
+
+        if (scanSpeed > 0)
+        {
+            if (scanSpeed != m_StreamingRate.ScanSpeed)
+                m_Hyperion->set_laser_scan_speed(scanSpeed);
+
+            m_StreamingRate.ScanSpeed = scanSpeed;
+            m_StreamingRate.Divider   = std::max(int(scanSpeed / requiredRate), 1);
+        }
+    }
+
+    m_StreamingRate.Rate = double(m_StreamingRate.ScanSpeed) / m_StreamingRate.Divider;
+
+    CMN_LOG_INIT_VERBOSE << "HyperionInterrogator: laser scan speed " << m_StreamingRate.ScanSpeed
+                         << " Hz, streaming divider " << m_StreamingRate.Divider
+                         << ", peak output rate " << m_StreamingRate.Rate << " Hz" << std::endl;
+}
+
+bool HyperionInterrogator::SetStreamingDivider(const int divider)
+{
+    if (!m_Hyperion || divider < 1)
+        return false;
+
+    try
+    {
+        if (IsStreamingSpectrum())
+            m_Hyperion->set_spectrum_stream_divider(divider);
+
+        if (!m_SpectrumPeakDetector)
+            m_Hyperion->set_peak_stream_divider(divider);
+    }
+    catch(const std::exception& e)
+    {
+        CMN_LOG_RUN_ERROR << "HyperionInterrogator: failed to set the streaming divider to " << divider
+                          << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    m_StreamingRate.Divider = divider;
+    m_StreamingRate.Rate    = double(m_StreamingRate.ScanSpeed) / divider;
+
+    return true;
+}
+
+size_t HyperionInterrogator::GetNumberOfQueuedFrames() const
+{
+    if (!m_isStreaming || m_SpectrumPeakDetector)
+        return 0;
+
+    return m_Hyperion->get_num_queued_peaks();
+}
+
 bool HyperionInterrogator::StreamPeaks()
 {
-    int streamingDivider = 1;
-    m_Hyperion->enable_peak_streaming(streamingDivider);
+    SelectStreamingRate();
+
+    if (IsStreamingSpectrum())
+        m_Hyperion->enable_spectrum_streaming(m_StreamingRate.Divider);
+
+    if (m_SpectrumPeakDetector)
+    {
+        m_isStreaming = true;
+
+        return GetIsStreaming();
+    }
+
+    m_Hyperion->enable_peak_streaming(m_StreamingRate.Divider);
     m_isStreaming = true;
 
     m_Hyperion->stream_peaks(); // clear the buffer
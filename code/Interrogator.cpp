@@ -1,6 +1,9 @@
 #include "mtsFBGSensor/mtsFBGSensor/Interrogator.h"
 
+#include <algorithm>
+
 #include "mtsFBGSensor/hyperion/HyperionInterrogator.h"
+#include "mtsFBGSensor/mtsFBGSensor/MultiInterrogator.h"
 
 Interrogator* InterrogatorFactory::CreateInterrogator(const InterrogatorType& type, const std::string& ipAddress, const unsigned int port)
 {
@@ -9,6 +12,10 @@ Interrogator* InterrogatorFactory::CreateInterrogator(const InterrogatorType& ty
         case InterrogatorType::HYPERION:
             interrogator = new HyperionInterrogator(ipAddress, port);
             break;
+
+        case InterrogatorType::MULTI:
+            interrogator = new MultiInterrogator();
+            break;
         
         default:
             throw std::invalid_argument("Interrogator type is not supported.");
@@ -27,6 +34,10 @@ Interrogator* InterrogatorFactory::CreateInterrogator(const InterrogatorType& ty
             port = HyperionInterrogator::DEFAULT_PORT;
             break;
 
+        case InterrogatorType::MULTI:
+            port = 0; // each backend has its own address
+            break;
+
         default:
             std::cerr << "Interrogator type not implemented!" << std::endl;
             port = -1;
@@ -35,4 +46,31 @@ Interrogator* InterrogatorFactory::CreateInterrogator(const InterrogatorType& ty
 
     return CreateInterrogator(type, ipAddress, port);
 
-}
\ No newline at end of file
+}
+
+bool InterrogatorFactory::ParseInterrogatorType(std::string name, InterrogatorType& type)
+{
+    std::transform(
+        name.begin(),
+        name.end(),
+        name.begin(),
+        [] (unsigned char c) {return std::toupper(c);}
+    );
+
+    if (name == "HYPERION")
+        type = InterrogatorType::HYPERION;
+
+    else if (name == "SI155")
+        type = InterrogatorType::SI155;
+
+    else if (name == "SM130")
+        type = InterrogatorType::SM130;
+
+    else if (name == "MULTI")
+        type = InterrogatorType::MULTI;
+
+    else
+        return false;
+
+    return true;
+}
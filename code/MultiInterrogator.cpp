@@ -0,0 +1,513 @@
+#include "mtsFBGSensor/mtsFBGSensor/MultiInterrogator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <cisstCommon/cmnLogger.h>
+
+MultiInterrogator::MultiInterrogator() :
+    Interrogator("", 0)
+{
+
+}
+
+MultiInterrogator::~MultiInterrogator()
+{
+    StopReaders();
+}
+
+void MultiInterrogator::Configure(const Json::Value& jsonConfig)
+{
+    const Json::Value jsonBackends = jsonConfig["Interrogators"];
+    for (Json::Value::ArrayIndex i = 0; i != jsonBackends.size(); i++)
+    {
+        const Json::Value jsonBackend = jsonBackends[i];
+
+        InterrogatorType type;
+        std::string      typeName = jsonBackend.get("Interrogator_Type", "").asString();
+        if (!InterrogatorFactory::ParseInterrogatorType(typeName, type) || type == InterrogatorType::MULTI)
+        {
+            CMN_LOG_INIT_ERROR << "MultiInterrogator: invalid \"Interrogator_Type\" \"" << typeName
+                               << "\" for interrogator " << i << ", ignoring it" << std::endl;
+            continue;
+        }
+
+        std::unique_ptr<Backend> backend(new Backend());
+        try
+        {
+            std::string ipAddress = jsonBackend["IP_Address"].asString();
+            if (jsonBackend.isMember("Port"))
+                backend->Device.reset(InterrogatorFactory::CreateInterrogator(type, ipAddress, jsonBackend["Port"].asUInt()));
+            else
+                backend->Device.reset(InterrogatorFactory::CreateInterrogator(type, ipAddress));
+        }
+        catch(const std::exception& e)
+        {
+            CMN_LOG_INIT_ERROR << "MultiInterrogator: failed to create interrogator " << i << ": " << e.what() << std::endl;
+            continue;
+        }
+
+        // the backend's own settings ("Streaming", "Peak_Source", ...) live in its entry
+        backend->Device->Configure(jsonBackend);
+
+        backend->NumChannels = jsonBackend.get("Channels", 0).asUInt();
+        backend->ClockOffset = jsonBackend.get("Clock_Offset", 0.0).asDouble();
+
+        m_Backends.push_back(std::move(backend));
+    }
+
+    if (m_Backends.empty())
+        CMN_LOG_INIT_ERROR << "MultiInterrogator: no valid \"Interrogators\" configured" << std::endl;
+
+    // the readers acquire in place of the sensor's thread
+    if (jsonConfig.isMember("Real_Time"))
+        m_ReaderRealTimeSettings.Configure(jsonConfig["Real_Time"]);
+
+    if (!jsonConfig.isMember("Alignment"))
+        return;
+
+    const Json::Value jsonAlignment = jsonConfig["Alignment"];
+
+    if (jsonAlignment.isMember("Mode"))
+    {
+        std::string mode = jsonAlignment["Mode"].asString();
+        std::transform(
+            mode.begin(),
+            mode.end(),
+            mode.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+
+        if (mode == "NEAREST")
+            m_Mode = AlignmentMode::NEAREST;
+
+        else if (mode == "LINEAR")
+            m_Mode = AlignmentMode::LINEAR;
+
+        else
+            CMN_LOG_INIT_ERROR << "MultiInterrogator: invalid alignment \"Mode\" \"" << mode
+                               << "\", using \"NEAREST\"" << std::endl;
+    }
+
+    if (jsonAlignment.isMember("Tolerance"))
+        m_Tolerance = jsonAlignment["Tolerance"].asDouble();
+
+    if (jsonAlignment.isMember("Buffer_Size"))
+        m_BufferSize = std::max(jsonAlignment["Buffer_Size"].asUInt(), 2u);
+
+    if (jsonAlignment.isMember("Estimate_Clock_Offsets"))
+        m_EstimateClockOffsets = jsonAlignment["Estimate_Clock_Offsets"].asBool();
+
+    for (auto& backend : m_Backends)
+        backend->Synchronizer.Configure(jsonAlignment["Clock_Synchronization"]);
+
+}
+
+int MultiInterrogator::GetNumberOfChannels() const
+{
+    int numChannels = 0;
+    for (const auto& backend : m_Backends)
+        numChannels += backend->NumChannels;
+
+    return numChannels;
+}
+
+bool MultiInterrogator::Connect()
+{
+    for (auto& backend : m_Backends)
+    {
+        std::lock_guard<std::mutex> lock(backend->DeviceMutex);
+
+        if (!backend->Device->Connect())
+            return false;
+
+        if (backend->NumChannels == 0)
+            backend->NumChannels = backend->Device->GetNumberOfChannels();
+    }
+
+    return !m_Backends.empty();
+}
+
+bool MultiInterrogator::Disconnect()
+{
+    DisableStreamPeaks();
+
+    bool success = true;
+    for (auto& backend : m_Backends)
+    {
+        std::lock_guard<std::mutex> lock(backend->DeviceMutex);
+        success = backend->Device->Disconnect() && success;
+    }
+
+    return success;
+}
+
+bool MultiInterrogator::StreamPeaks()
+{
+    StopReaders();
+
+    for (auto& backend : m_Backends)
+    {
+        std::lock_guard<std::mutex> lock(backend->DeviceMutex);
+        if (!backend->Device->StreamPeaks())
+            return false;
+
+        std::lock_guard<std::mutex> framesLock(backend->FramesMutex);
+        backend->Frames.clear();
+        backend->Synchronizer.Reset();
+    }
+
+    m_StopReaders = false;
+    for (size_t i = 0; i < m_Backends.size(); i++)
+        m_Backends[i]->Reader = std::thread(&MultiInterrogator::ReaderLoop, this, std::ref(*m_Backends[i]), i);
+
+    m_isStreaming = true;
+
+    return GetIsStreaming();
+}
+
+bool MultiInterrogator::DisableStreamPeaks()
+{
+    StopReaders();
+
+    for (auto& backend : m_Backends)
+    {
+        std::lock_guard<std::mutex> lock(backend->DeviceMutex);
+        backend->Device->DisableStreamPeaks();
+    }
+    m_isStreaming = false;
+
+    return !GetIsStreaming();
+}
+
+void MultiInterrogator::StopReaders()
+{
+    m_StopReaders = true;
+
+    for (auto& backend : m_Backends)
+    {
+        backend->FrameCondition.notify_all();
+        if (backend->Reader.joinable())
+            backend->Reader.join();
+    }
+}
+
+int MultiInterrogator::GetStreamingDivider() const
+{
+    if (m_Backends.empty())
+        return 1;
+
+    Backend& reference = *m_Backends.front();
+    std::lock_guard<std::mutex> lock(reference.DeviceMutex);
+
+    return reference.Device->GetStreamingDivider();
+}
+
+bool MultiInterrogator::SetStreamingDivider(const int divider)
+{
+    bool success = !m_Backends.empty();
+    for (auto& backend : m_Backends)
+    {
+        std::lock_guard<std::mutex> lock(backend->DeviceMutex);
+        success = backend->Device->SetStreamingDivider(divider) && success;
+    }
+
+    return success;
+}
+
+double MultiInterrogator::GetStreamingRate() const
+{
+    if (m_Backends.empty())
+        return 0.0;
+
+    Backend& reference = *m_Backends.front();
+    std::lock_guard<std::mutex> lock(reference.DeviceMutex);
+
+    return reference.Device->GetStreamingRate();
+}
+
+size_t MultiInterrogator::GetNumberOfQueuedFrames() const
+{
+    if (m_Backends.empty())
+        return 0;
+
+    Backend& reference = *m_Backends.front();
+    std::lock_guard<std::mutex> lock(reference.FramesMutex);
+
+    return reference.Frames.size();
+}
+
+int MultiInterrogator::GetStreamingBufferAvailable() const
+{
+    int available = 100;
+    for (const auto& backend : m_Backends)
+    {
+        std::lock_guard<std::mutex> lock(backend->DeviceMutex);
+        available = std::min(available, backend->Device->GetStreamingBufferAvailable());
+    }
+
+    return available;
+}
+
+size_t MultiInterrogator::GetNumberOfCollapsedFrames() const
+{
+    if (m_Backends.empty())
+        return 1;
+
+    Backend& reference = *m_Backends.front();
+    std::lock_guard<std::mutex> lock(reference.DeviceMutex);
+
+    return reference.Device->GetNumberOfCollapsedFrames();
+}
+
+double MultiInterrogator::GetClockOffset(const size_t backend) const
+{
+    return backend < m_Backends.size() ? m_Backends[backend]->ClockOffset.load() : 0.0;
+}
+
+vctDoubleVec MultiInterrogator::GetPeaks(const size_t channelId) const
+{
+    size_t firstChannel = 1;
+    for (const auto& backend : m_Backends)
+    {
+        if (channelId < firstChannel + backend->NumChannels)
+        {
+            std::lock_guard<std::mutex> lock(backend->DeviceMutex);
+            return backend->Device->GetPeaks(channelId - firstChannel + 1);
+        }
+        firstChannel += backend->NumChannels;
+    }
+
+    return vctDoubleVec();
+}
+
+std::vector<vctDoubleVec> MultiInterrogator::GetChannelPeaks() const
+{
+    if (m_Backends.empty())
+        return std::vector<vctDoubleVec>();
+
+    std::vector<Frame> frames(m_Backends.size());
+    std::vector<bool>  aligned(m_Backends.size(), true);
+
+    // polled: the frames are read one after the other, there is nothing to align
+    if (!m_isStreaming)
+    {
+        for (size_t i = 0; i < m_Backends.size(); i++)
+            frames[i] = ReadFrame(*m_Backends[i]);
+
+        MergeFrames(frames, aligned);
+
+        return m_Merged.ChannelPeaks;
+    }
+
+    // the reference backend paces the merged frames
+    Backend& reference = *m_Backends.front();
+    {
+        std::unique_lock<std::mutex> lock(reference.FramesMutex);
+        reference.FrameCondition.wait_for(
+            lock,
+            std::chrono::seconds(1),
+            [&] { return !reference.Frames.empty() || m_StopReaders; }
+        );
+
+        if (reference.Frames.empty())
+            return m_Merged.ChannelPeaks;
+
+        frames[0] = std::move(reference.Frames.front());
+        reference.Frames.pop_front();
+    }
+
+    for (size_t i = 1; i < m_Backends.size(); i++)
+        aligned[i] = AlignFrame(*m_Backends[i], frames[0].Time, frames[i]);
+
+    MergeFrames(frames, aligned);
+
+    return m_Merged.ChannelPeaks;
+}
+
+void MultiInterrogator::ReaderLoop(Backend& backend, const size_t index)
+{
+    if (m_ReaderRealTimeSettings.IsConfigured())
+    {
+        std::string report;
+        if (m_ReaderRealTimeSettings.Apply("MultiInterrogator reader " + std::to_string(index), report))
+            CMN_LOG_RUN_VERBOSE << report << std::endl;
+        else
+            CMN_LOG_RUN_WARNING << report << std::endl;
+    }
+
+    // a failing backend is retried less and less often, and logged once every 100 failures
+    const std::chrono::milliseconds minRetryDelay(10);
+    const std::chrono::milliseconds maxRetryDelay(500);
+    std::chrono::milliseconds       retryDelay  = minRetryDelay;
+    size_t                          numFailures = 0;
+
+    while (!m_StopReaders)
+    {
+        Frame frame;
+        try
+        {
+            frame = ReadFrame(backend);
+        }
+        catch(const std::exception& e)
+        {
+            if (numFailures % 100 == 0)
+                CMN_LOG_RUN_ERROR << "MultiInterrogator: backend " << index << " failed to read a frame: " << e.what()
+                                  << " (" << numFailures + 1 << " consecutive failures)" << std::endl;
+            numFailures++;
+
+            std::this_thread::sleep_for(retryDelay);
+            retryDelay = std::min(2 * retryDelay, maxRetryDelay);
+            continue;
+        }
+
+        if (numFailures > 0)
+        {
+            CMN_LOG_RUN_WARNING << "MultiInterrogator: backend " << index << " recovered after "
+                                << numFailures << " failed reads" << std::endl;
+            numFailures = 0;
+            retryDelay  = minRetryDelay;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(backend.FramesMutex);
+            backend.Frames.push_back(std::move(frame));
+
+            if (backend.Frames.size() > m_BufferSize)
+                backend.Frames.pop_front();
+        }
+        backend.FrameCondition.notify_all();
+    }
+}
+
+MultiInterrogator::Frame MultiInterrogator::ReadFrame(Backend& backend) const
+{
+    Frame  frame;
+    double instrumentTime;
+    {
+        std::lock_guard<std::mutex> lock(backend.DeviceMutex);
+        frame.ChannelPeaks = backend.Device->GetChannelPeaks();
+        frame.Quality      = backend.Device->GetChannelPeakQuality();
+        instrumentTime     = backend.Device->GetPeaksTimestamp();
+        frame.SerialNumber = backend.Device->GetPeaksSerialNumber();
+    }
+    double hostTime = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    // backends without instrument timestamps are aligned on their receive time
+    if (std::isnan(instrumentTime))
+    {
+        frame.Time = hostTime;
+        return frame;
+    }
+
+    if (m_EstimateClockOffsets)
+    {
+        backend.Synchronizer.AddSample(instrumentTime, hostTime);
+        backend.ClockOffset = backend.Synchronizer.GetOffset();
+
+        frame.Time = backend.Synchronizer.ToHostTime(instrumentTime);
+        return frame;
+    }
+
+    frame.Time = instrumentTime + backend.ClockOffset;
+
+    return frame;
+}
+
+bool MultiInterrogator::AlignFrame(Backend& backend, const double time, Frame& aligned) const
+{
+    std::unique_lock<std::mutex> lock(backend.FramesMutex);
+
+    // a later frame may still be closer, wait for one at or after the reference time (bounded by the tolerance)
+    backend.FrameCondition.wait_for(
+        lock,
+        std::chrono::duration<double>(m_Tolerance),
+        [&] { return m_StopReaders || (!backend.Frames.empty() && backend.Frames.back().Time >= time); }
+    );
+
+    // frames before the last one preceding the reference time are of no use to later reference frames either
+    while (backend.Frames.size() >= 2 && backend.Frames[1].Time <= time)
+        backend.Frames.pop_front();
+
+    if (backend.Frames.empty())
+        return false;
+
+    const Frame* before = backend.Frames[0].Time <= time ? &backend.Frames[0] : nullptr;
+    const Frame* after  = nullptr;
+    for (const Frame& frame : backend.Frames)
+    {
+        if (frame.Time > time)
+        {
+            after = &frame;
+            break;
+        }
+    }
+
+    const Frame* nearest = before;
+    if (!nearest || (after && after->Time - time < time - before->Time))
+        nearest = after;
+
+    if (!nearest || std::abs(nearest->Time - time) > m_Tolerance)
+        return false;
+
+    aligned      = *nearest;
+    aligned.Time = time;
+
+    if (m_Mode != AlignmentMode::LINEAR || !before || !after)
+        return true;
+
+    // interpolation needs the same peaks in both frames
+    if (before->ChannelPeaks.size() != after->ChannelPeaks.size())
+        return true;
+
+    for (size_t ch = 0; ch < before->ChannelPeaks.size(); ch++)
+        if (before->ChannelPeaks[ch].size() != after->ChannelPeaks[ch].size())
+            return true;
+
+    double weight = (time - before->Time) / (after->Time - before->Time);
+    for (size_t ch = 0; ch < aligned.ChannelPeaks.size(); ch++)
+        for (size_t i = 0; i < aligned.ChannelPeaks[ch].size(); i++)
+            aligned.ChannelPeaks[ch][i] = (1.0 - weight) * before->ChannelPeaks[ch][i] + weight * after->ChannelPeaks[ch][i];
+
+    return true;
+}
+
+void MultiInterrogator::MergeFrames(const std::vector<Frame>& frames, const std::vector<bool>& aligned) const
+{
+    m_Merged.Time         = frames.front().Time;
+    m_Merged.SerialNumber = frames.front().SerialNumber;
+    m_Merged.ChannelPeaks.clear();
+    m_Merged.Quality.clear();
+
+    bool allAligned = true;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        const Frame& frame = frames[i];
+        allAligned = allAligned && aligned[i];
+
+        // every backend keeps its channel numbers even when it has nothing to contribute
+        size_t numChannels = m_Backends[i]->NumChannels > 0 ? m_Backends[i]->NumChannels : frame.ChannelPeaks.size();
+        for (size_t ch = 0; ch < numChannels; ch++)
+        {
+            vctDoubleVec peaks;
+            if (aligned[i] && ch < frame.ChannelPeaks.size())
+                peaks = frame.ChannelPeaks[ch];
+
+            vctDoubleMat quality;
+            if (aligned[i] && ch < frame.Quality.size() && frame.Quality[ch].rows() == peaks.size())
+                quality = frame.Quality[ch];
+            else
+            {
+                quality.SetSize(peaks.size(), NUM_PEAK_QUALITY_METRICS);
+                quality.SetAll(std::numeric_limits<double>::quiet_NaN());
+            }
+
+            m_Merged.ChannelPeaks.push_back(peaks);
+            m_Merged.Quality.push_back(quality);
+        }
+    }
+
+    if (!allAligned)
+        m_NumUnaligned++;
+}
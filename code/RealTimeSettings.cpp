@@ -0,0 +1,216 @@
+#include "mtsFBGSensor/Utilities/RealTimeSettings.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace
+{
+    // touches the pages of a stack frame of the given size so later calls do not fault
+    __attribute__((noinline)) void PrefaultStack(const size_t size)
+    {
+        const size_t chunk = 16 * 1024;
+        volatile unsigned char buffer[chunk];
+        std::memset(const_cast<unsigned char*>(buffer), 0, chunk);
+
+        if (size > chunk)
+            PrefaultStack(size - chunk);
+
+        // keeps this frame alive across the recursion (no tail call)
+        (void) buffer[0];
+    }
+
+    // touches heap pages that stay mapped after being freed (trimming and mmap are disabled with locked memory)
+    void PrefaultHeap(const size_t size)
+    {
+        unsigned char* buffer = static_cast<unsigned char*>(std::malloc(size));
+        if (!buffer)
+            return;
+
+        long pageSize = ::sysconf(_SC_PAGESIZE);
+        for (size_t i = 0; i < size; i += size_t(pageSize))
+            buffer[i] = 0;
+
+        std::free(buffer);
+    }
+
+    std::mutex g_MemoryMutex;
+    bool       g_IsMemoryLocked = false;
+
+} // namespace
+
+void RealTimeSettings::Configure(const Json::Value& jsonConfig)
+{
+    if (jsonConfig.isMember("Policy"))
+    {
+        m_Policy = jsonConfig["Policy"].asString();
+        std::transform(
+            m_Policy.begin(),
+            m_Policy.end(),
+            m_Policy.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+    }
+
+    if (jsonConfig.isMember("Priority"))
+    {
+        m_Priority = jsonConfig["Priority"].asInt();
+
+        // a priority alone asks for FIFO scheduling
+        if (!jsonConfig.isMember("Policy"))
+            m_Policy = "FIFO";
+    }
+
+    m_CPUAffinity.clear();
+    const Json::Value jsonAffinity = jsonConfig["CPU_Affinity"];
+    for (Json::Value::ArrayIndex i = 0; i != jsonAffinity.size(); i++)
+        m_CPUAffinity.push_back(jsonAffinity[i].asInt());
+
+    if (jsonConfig.isMember("Lock_Memory"))
+        m_LockMemory = jsonConfig["Lock_Memory"].asBool();
+
+    if (jsonConfig.isMember("Prefault_Stack"))
+        m_PrefaultStack = jsonConfig["Prefault_Stack"].asUInt64();
+
+    if (jsonConfig.isMember("Prefault_Heap"))
+        m_PrefaultHeap = jsonConfig["Prefault_Heap"].asUInt64();
+
+    m_IsConfigured = true;
+}
+
+bool RealTimeSettings::Apply(const std::string& threadName, std::string& report) const
+{
+    std::ostringstream message;
+    message << "real-time settings of " << threadName << ":";
+    bool success = true;
+
+    // scheduling
+    std::string policyName = m_Policy;
+    int         policy     = SCHED_OTHER;
+    if (m_Policy == "FIFO")
+        policy = SCHED_FIFO;
+    else if (m_Policy == "RR")
+        policy = SCHED_RR;
+    else if (m_Policy != "OTHER")
+    {
+        message << "\n  policy: unknown policy \"" << m_Policy << "\"";
+        policyName = "OTHER";
+        success    = false;
+    }
+
+    sched_param param;
+    param.sched_priority = policy == SCHED_OTHER ? 0 : std::min(
+        std::max(m_Priority, sched_get_priority_min(policy)),
+        sched_get_priority_max(policy)
+    );
+
+    int result = pthread_setschedparam(pthread_self(), policy, &param);
+    if (result == 0)
+        message << "\n  policy: " << policyName << ", priority " << param.sched_priority;
+    else
+    {
+        message << "\n  policy: failed to set " << policyName << " priority " << param.sched_priority
+                << " (" << std::strerror(result) << ")";
+        success = false;
+    }
+
+    // affinity
+#ifdef __linux__
+    if (!m_CPUAffinity.empty())
+    {
+        // CPUs the set cannot hold are reported, the others still applied
+        cpu_set_t        cpuSet;
+        std::vector<int> validCPUs;
+        CPU_ZERO(&cpuSet);
+        for (int cpu : m_CPUAffinity)
+        {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+            {
+                CPU_SET(cpu, &cpuSet);
+                validCPUs.push_back(cpu);
+            }
+            else
+            {
+                message << "\n  CPU affinity: failed to add CPU " << cpu << " (outside [0, " << CPU_SETSIZE << "))";
+                success = false;
+            }
+        }
+
+        if (!validCPUs.empty())
+        {
+            result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+
+            message << "\n  CPU affinity: ";
+            for (size_t i = 0; i < validCPUs.size(); i++)
+                message << (i > 0 ? "," : "") << validCPUs[i];
+
+            if (result != 0)
+            {
+                message << " failed (" << std::strerror(result) << ")";
+                success = false;
+            }
+        }
+    }
+#else
+    if (!m_CPUAffinity.empty())
+    {
+        message << "\n  CPU affinity: not supported on this platform";
+        success = false;
+    }
+#endif
+
+    // memory is locked once for the whole process
+    if (m_LockMemory)
+    {
+        std::lock_guard<std::mutex> lock(g_MemoryMutex);
+        if (!g_IsMemoryLocked)
+        {
+            if (::mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+            {
+#ifdef __GLIBC__
+                // freed memory stays in the (locked) heap instead of going back to the system
+                mallopt(M_TRIM_THRESHOLD, -1);
+                mallopt(M_MMAP_MAX, 0);
+#endif
+                g_IsMemoryLocked = true;
+                message << "\n  memory: locked";
+            }
+            else
+            {
+                message << "\n  memory: mlockall failed (" << std::strerror(errno) << ")";
+                success = false;
+            }
+        }
+        else
+            message << "\n  memory: already locked";
+
+        if (g_IsMemoryLocked && m_PrefaultHeap > 0)
+        {
+            PrefaultHeap(m_PrefaultHeap);
+            message << "\n  heap: " << m_PrefaultHeap / 1024 << " KiB prefaulted";
+        }
+    }
+
+    if (m_PrefaultStack > 0)
+    {
+        PrefaultStack(m_PrefaultStack);
+        message << "\n  stack: " << m_PrefaultStack / 1024 << " KiB prefaulted";
+    }
+
+    report = message.str();
+
+    return success;
+}
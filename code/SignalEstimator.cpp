@@ -0,0 +1,340 @@
+#include "mtsFBGSensor/SensorFilters/SignalEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <cisstCommon/cmnLogger.h>
+
+namespace
+{
+    std::string ToUpper(std::string text)
+    {
+        std::transform(
+            text.begin(),
+            text.end(),
+            text.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+        return text;
+    }
+
+} // namespace
+
+void SignalEstimator::Configure(const Json::Value& jsonConfig)
+{
+    m_Enabled = jsonConfig.get("Enabled", true).asBool();
+
+    if (jsonConfig.isMember("Type"))
+    {
+        std::string type = ToUpper(jsonConfig["Type"].asString());
+
+        if (type == "BOXCAR")
+            m_Type = Type::BOXCAR;
+
+        else if (type == "KALMAN")
+            m_Type = Type::KALMAN;
+
+        else if (type == "BUTTERWORTH")
+            m_Type = Type::BUTTERWORTH;
+
+        else
+        {
+            CMN_LOG_INIT_ERROR << "SignalEstimator: invalid \"Type\" \"" << type
+                               << "\", disabling the estimator" << std::endl;
+            m_Enabled = false;
+        }
+    }
+
+    if (jsonConfig.isMember("Sample_Rate") && jsonConfig["Sample_Rate"].asDouble() > 0)
+        m_SampleRate = jsonConfig["Sample_Rate"].asDouble();
+
+    if (jsonConfig.isMember("Num_Samples"))
+        m_NumSamples = std::max(jsonConfig["Num_Samples"].asUInt(), 1u);
+
+    if (jsonConfig.isMember("Model"))
+    {
+        std::string model = ToUpper(jsonConfig["Model"].asString());
+
+        if (model == "CONSTANT_VELOCITY")
+            m_ConstantVelocity = true;
+
+        else if (model == "RANDOM_WALK")
+            m_ConstantVelocity = false;
+
+        else
+            CMN_LOG_INIT_ERROR << "SignalEstimator: invalid \"Model\" \"" << model
+                               << "\", using \"CONSTANT_VELOCITY\"" << std::endl;
+    }
+
+    if (jsonConfig.isMember("Process_Noise"))
+        m_ProcessNoise = jsonConfig["Process_Noise"].asDouble();
+
+    if (jsonConfig.isMember("Measurement_Noise"))
+        m_MeasurementNoise = jsonConfig["Measurement_Noise"].asDouble();
+
+    if (jsonConfig.isMember("Order"))
+    {
+        // odd orders are rounded up to whole biquads
+        m_Order = std::max(jsonConfig["Order"].asUInt(), 1u);
+        m_Order = std::min<size_t>(m_Order + (m_Order % 2), 8);
+    }
+
+    if (jsonConfig.isMember("Cutoff_Frequency"))
+        m_CutoffFrequency = jsonConfig["Cutoff_Frequency"].asDouble();
+
+    if (m_Type == Type::BUTTERWORTH && !(m_CutoffFrequency > 0 && m_CutoffFrequency < 0.5 * m_SampleRate))
+    {
+        CMN_LOG_INIT_ERROR << "SignalEstimator: \"Cutoff_Frequency\" must be between 0 and half the \"Sample_Rate\""
+                           << ", disabling the estimator" << std::endl;
+        m_Enabled = false;
+    }
+
+    m_Sections = FilterBank::DesignButterworth(m_Order, m_CutoffFrequency, m_SampleRate);
+    Reset();
+}
+
+std::string SignalEstimator::GetDescription() const
+{
+    std::ostringstream description;
+    switch (m_Type)
+    {
+        case Type::BOXCAR:
+            description << "Boxcar (" << m_NumSamples << " samples)";
+            break;
+
+        case Type::KALMAN:
+            description << "Kalman (" << (m_ConstantVelocity ? "constant velocity" : "random walk")
+                        << ", Q " << m_ProcessNoise << ", R " << m_MeasurementNoise << ")";
+            break;
+
+        case Type::BUTTERWORTH:
+            description << "Butterworth (order " << m_Order << ", " << m_CutoffFrequency << " Hz)";
+            break;
+    }
+
+    return description.str();
+}
+
+void SignalEstimator::Reset()
+{
+    m_IsReady    = false;
+    m_NumUpdates = 0;
+    m_LastTime   = std::numeric_limits<double>::quiet_NaN();
+    m_Estimate.SetSize(0);
+}
+
+void SignalEstimator::AddOffset(const vctDoubleVec& offset)
+{
+    size_t numElements = m_Estimate.size();
+    if (m_NumUpdates == 0 || offset.size() != numElements)
+        return;
+
+    for (size_t i = 0; i < numElements; i++)
+        m_Estimate[i] += offset[i];
+
+    switch (m_Type)
+    {
+        case Type::BOXCAR:
+        {
+            // rows not filled yet are overwritten before they are summed
+            size_t numInWindow = std::min(m_NumUpdates, m_NumSamples);
+            for (size_t i = 0; i < numElements; i++)
+            {
+                for (size_t j = 0; j < m_NumSamples; j++)
+                    m_Window.Element(j, i) += offset[i];
+
+                m_WindowSum[i] += double(numInWindow) * offset[i];
+            }
+            break;
+        }
+
+        case Type::KALMAN:
+            // the rate and the covariances do not depend on the offset
+            break;
+
+        case Type::BUTTERWORTH:
+            // every section (unit DC gain) moves by its steady state for the offset
+            for (size_t i = 0; i < numElements; i++)
+            {
+                for (size_t s = 0; s < m_Sections.size(); s++)
+                {
+                    const Biquad& section = m_Sections[s];
+                    double        z2      = (section.B2 - section.A2) * offset[i];
+                    m_SectionStates.Element(i, 2 * s + 1) += z2;
+                    m_SectionStates.Element(i, 2 * s)     += (section.B1 - section.A1) * offset[i] + z2;
+                }
+            }
+            break;
+    }
+}
+
+bool SignalEstimator::Update(const double time, const vctDoubleVec& sample)
+{
+    if (m_Estimate.size() != sample.size())
+        m_NumUpdates = 0;
+
+    switch (m_Type)
+    {
+        case Type::BOXCAR:
+            UpdateBoxcar(sample);
+            break;
+
+        case Type::KALMAN:
+            UpdateKalman(time, sample);
+            break;
+
+        case Type::BUTTERWORTH:
+            UpdateButterworth(sample);
+            break;
+    }
+
+    m_NumUpdates++;
+    m_LastTime = time;
+    return m_IsReady;
+}
+
+void SignalEstimator::UpdateBoxcar(const vctDoubleVec& sample)
+{
+    size_t numElements = sample.size();
+    if (m_NumUpdates == 0)
+    {
+        m_Window.SetSize(m_NumSamples, numElements);
+        m_WindowSum.SetSize(numElements);
+        m_WindowSum.SetAll(0.0);
+        m_Estimate.SetSize(numElements);
+        m_IsReady = false;
+    }
+
+    size_t row = m_NumUpdates % m_NumSamples;
+    bool   isFull = m_NumUpdates >= m_NumSamples;
+    for (size_t i = 0; i < numElements; i++)
+    {
+        if (isFull)
+            m_WindowSum[i] -= m_Window.Element(row, i);
+
+        m_Window.Element(row, i) = sample[i];
+        m_WindowSum[i]          += sample[i];
+    }
+
+    // the running sum is rebuilt once per window so rounding errors do not accumulate
+    if (row == m_NumSamples - 1)
+    {
+        for (size_t i = 0; i < numElements; i++)
+        {
+            m_WindowSum[i] = 0.0;
+            for (size_t j = 0; j < m_NumSamples; j++)
+                m_WindowSum[i] += m_Window.Element(j, i);
+        }
+    }
+
+    size_t numInWindow = std::min(m_NumUpdates + 1, m_NumSamples);
+    for (size_t i = 0; i < numElements; i++)
+        m_Estimate[i] = m_WindowSum[i] / double(numInWindow);
+
+    m_IsReady = numInWindow == m_NumSamples;
+}
+
+void SignalEstimator::UpdateKalman(const double time, const vctDoubleVec& sample)
+{
+    size_t numElements = sample.size();
+    if (m_NumUpdates == 0)
+    {
+        m_Estimate.SetSize(numElements);
+        m_Rate.SetSize(numElements);
+        m_Covariance.SetSize(numElements, 3);
+        for (size_t i = 0; i < numElements; i++)
+        {
+            // the rate is unknown until the next samples
+            m_Estimate[i]               = sample[i];
+            m_Rate[i]                   = 0.0;
+            m_Covariance.Element(i, 0) = m_MeasurementNoise;
+            m_Covariance.Element(i, 1) = 0.0;
+            m_Covariance.Element(i, 2) = m_ConstantVelocity ? m_MeasurementNoise * m_SampleRate * m_SampleRate : 0.0;
+        }
+        m_IsReady = true;
+        return;
+    }
+
+    double dt = time - m_LastTime;
+    if (!(dt > 0.0) || !std::isfinite(dt))
+        dt = 1.0 / m_SampleRate;
+
+    double q = m_ProcessNoise;
+    double R = m_MeasurementNoise;
+    for (size_t i = 0; i < numElements; i++)
+    {
+        double& P00 = m_Covariance.Element(i, 0);
+        double& P01 = m_Covariance.Element(i, 1);
+        double& P11 = m_Covariance.Element(i, 2);
+
+        // predict
+        if (m_ConstantVelocity)
+        {
+            m_Estimate[i] += m_Rate[i] * dt;
+            P00 += dt * (2.0 * P01 + dt * P11) + q * dt * dt * dt / 3.0;
+            P01 += dt * P11 + q * dt * dt / 2.0;
+            P11 += q * dt;
+        }
+        else
+            P00 += q * dt;
+
+        // correct
+        double innovation = sample[i] - m_Estimate[i];
+        double S          = P00 + R;
+        double K0         = P00 / S;
+        double K1         = P01 / S;
+
+        m_Estimate[i] += K0 * innovation;
+        if (m_ConstantVelocity)
+        {
+            m_Rate[i] += K1 * innovation;
+            P11       -= K1 * P01;
+            P01       *= 1.0 - K0;
+        }
+        P00 *= 1.0 - K0;
+    }
+}
+
+void SignalEstimator::UpdateButterworth(const vctDoubleVec& sample)
+{
+    size_t numElements = sample.size();
+    size_t numSections = m_Sections.size();
+    if (m_NumUpdates == 0)
+    {
+        m_Estimate.SetSize(numElements);
+        m_SectionStates.SetSize(numElements, 2 * numSections);
+
+        // every section starts in the steady state of the first sample (unit DC gain)
+        for (size_t i = 0; i < numElements; i++)
+        {
+            for (size_t s = 0; s < numSections; s++)
+            {
+                const Biquad& section = m_Sections[s];
+                double        z2      = (section.B2 - section.A2) * sample[i];
+                m_SectionStates.Element(i, 2 * s + 1) = z2;
+                m_SectionStates.Element(i, 2 * s)     = (section.B1 - section.A1) * sample[i] + z2;
+            }
+            m_Estimate[i] = sample[i];
+        }
+        m_IsReady = true;
+        return;
+    }
+
+    for (size_t i = 0; i < numElements; i++)
+    {
+        double value = sample[i];
+        for (size_t s = 0; s < numSections; s++)
+        {
+            const Biquad& section = m_Sections[s];
+            double&       z1      = m_SectionStates.Element(i, 2 * s);
+            double&       z2      = m_SectionStates.Element(i, 2 * s + 1);
+
+            double output = section.B0 * value + z1;
+            z1    = section.B1 * value - section.A1 * output + z2;
+            z2    = section.B2 * value - section.A2 * output;
+            value = output;
+        }
+        m_Estimate[i] = value;
+    }
+}
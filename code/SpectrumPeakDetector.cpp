@@ -0,0 +1,473 @@
+#include "mtsFBGSensor/SpectrumProcessing/SpectrumPeakDetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+SpectrumPeakDetector::~SpectrumPeakDetector()
+{
+    StopWorkers();
+}
+
+void SpectrumPeakDetector::Configure(const Json::Value& jsonConfig)
+{
+    if (jsonConfig.isMember("Threshold"))
+        m_Threshold = jsonConfig["Threshold"].asDouble();
+
+    if (jsonConfig.isMember("Centroid_Level"))
+        m_CentroidLevel = jsonConfig["Centroid_Level"].asDouble();
+
+    if (jsonConfig.isMember("Noise_Samples"))
+        m_NoiseSamples = std::max(jsonConfig["Noise_Samples"].asUInt(), 1u);
+
+    if (jsonConfig.isMember("Fit_Method"))
+    {
+        std::string method = jsonConfig["Fit_Method"].asString();
+        std::transform(
+            method.begin(),
+            method.end(),
+            method.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+
+        if (method == "CENTROID")
+            m_FitMethod = FitMethod::CENTROID;
+
+        else if (method == "GAUSSIAN")
+            m_FitMethod = FitMethod::GAUSSIAN;
+
+        else if (method == "PARABOLIC")
+            m_FitMethod = FitMethod::PARABOLIC;
+
+        else
+            CMN_LOG_INIT_ERROR << "SpectrumPeakDetector: invalid \"Fit_Method\" \"" << method
+                               << "\", keeping the current method" << std::endl;
+    }
+
+    // windows are grouped per channel: [{"Channel": 1, "Wavelengths": [[min, max], ...]}, ...]
+    std::vector<SpectrumPeakWindow> windows;
+    const Json::Value jsonWindows = jsonConfig["Windows"];
+    for (Json::Value::ArrayIndex i = 0; i != jsonWindows.size(); i++)
+    {
+        size_t channel = jsonWindows[i]["Channel"].asUInt();
+        const Json::Value jsonWavelengths = jsonWindows[i]["Wavelengths"];
+        for (Json::Value::ArrayIndex j = 0; j != jsonWavelengths.size(); j++)
+        {
+            windows.push_back({
+                channel,
+                jsonWavelengths[j][0].asDouble(),
+                jsonWavelengths[j][1].asDouble()
+            });
+        }
+    }
+    SetWindows(windows);
+
+    // "Tracking": {"Enabled": true, "Half_Width": 0.05}
+    if (jsonConfig.isMember("Tracking"))
+    {
+        const Json::Value jsonTracking = jsonConfig["Tracking"];
+        SetTracking(
+            jsonTracking.get("Enabled", true).asBool(),
+            jsonTracking.get("Half_Width", m_TrackingHalfWidth).asDouble()
+        );
+    }
+
+    size_t numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    if (jsonConfig.isMember("Threads"))
+        numThreads = std::max(jsonConfig["Threads"].asUInt(), 1u);
+    SetNumberOfThreads(numThreads);
+}
+
+void SpectrumPeakDetector::SetWindows(const std::vector<SpectrumPeakWindow>& windows)
+{
+    // channels are 1-based, a missing "Channel" reads as 0
+    m_Windows.clear();
+    for (size_t i = 0; i < windows.size(); i++)
+    {
+        if (windows[i].Channel < 1)
+        {
+            CMN_LOG_INIT_ERROR << "SpectrumPeakDetector: window " << i << " ["
+                               << windows[i].WavelengthMin << ", " << windows[i].WavelengthMax
+                               << "] nm has no valid \"Channel\" (1-based), ignoring it" << std::endl;
+            continue;
+        }
+        m_Windows.push_back(windows[i]);
+    }
+
+    m_Peaks.assign(m_Windows.size(), SpectrumPeak());
+    m_Tracks.assign(m_Windows.size(), PeakTrack());
+
+    // group the windows of each channel into a single task
+    m_ChannelTasks.clear();
+    for (size_t i = 0; i < m_Windows.size(); i++)
+    {
+        auto task = std::find_if(
+            m_ChannelTasks.begin(),
+            m_ChannelTasks.end(),
+            [&] (const ChannelTask& t) { return t.Channel == m_Windows[i].Channel; }
+        );
+        if (task == m_ChannelTasks.end())
+        {
+            m_ChannelTasks.push_back({m_Windows[i].Channel, {}});
+            task = m_ChannelTasks.end() - 1;
+        }
+        task->WindowIndices.push_back(i);
+    }
+
+    if (m_NumPoints > 0)
+        SetScan(m_StartWavelength, m_DeltaWavelength, m_NumPoints, m_NumChannels);
+}
+
+void SpectrumPeakDetector::SetNumberOfThreads(const size_t numThreads)
+{
+    StopWorkers();
+
+    // the calling thread works as well, so spawn one less; no more than there are channels
+    m_NumThreads = std::max<size_t>(numThreads, 1);
+    size_t numWorkers = std::min(m_NumThreads, std::max<size_t>(m_ChannelTasks.size(), 1)) - 1;
+
+    m_Stop = false;
+    for (size_t i = 0; i < numWorkers; i++)
+        m_Workers.emplace_back(&SpectrumPeakDetector::WorkerLoop, this);
+}
+
+void SpectrumPeakDetector::SetTracking(const bool enabled, const double halfWidth)
+{
+    m_TrackingEnabled   = enabled;
+    m_TrackingHalfWidth = std::abs(halfWidth);
+
+    if (m_DeltaWavelength > 0)
+        m_TrackingHalfWidthPoints = size_t(std::ceil(m_TrackingHalfWidth / m_DeltaWavelength));
+
+    ResetTracking();
+}
+
+void SpectrumPeakDetector::ResetTracking()
+{
+    for (PeakTrack& track : m_Tracks)
+        track.Locked = false;
+}
+
+size_t SpectrumPeakDetector::GetNumberOfLockedPeaks() const
+{
+    return std::count_if(
+        m_Tracks.begin(),
+        m_Tracks.end(),
+        [] (const PeakTrack& track) { return track.Locked; }
+    );
+}
+
+size_t SpectrumPeakDetector::GetNumberOfReacquisitions() const
+{
+    size_t numReacquisitions = 0;
+    for (const PeakTrack& track : m_Tracks)
+        numReacquisitions += track.NumReacquisitions;
+
+    return numReacquisitions;
+}
+
+void SpectrumPeakDetector::SetScan(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels)
+{
+    m_StartWavelength = startWavelength;
+    m_DeltaWavelength = deltaWavelength;
+    m_NumPoints       = numPoints;
+    m_NumChannels     = numChannels;
+
+    m_Ranges.resize(m_Windows.size());
+    for (size_t i = 0; i < m_Windows.size(); i++)
+    {
+        const SpectrumPeakWindow& window = m_Windows[i];
+        if (window.Channel < 1 || window.Channel > m_NumChannels || m_DeltaWavelength <= 0)
+        {
+            m_Ranges[i] = {0, 0};
+            continue;
+        }
+
+        double first = std::ceil((window.WavelengthMin - m_StartWavelength) / m_DeltaWavelength);
+        double last  = std::floor((window.WavelengthMax - m_StartWavelength) / m_DeltaWavelength);
+
+        m_Ranges[i].Begin = size_t(std::min(std::max(first, 0.0), double(m_NumPoints)));
+        m_Ranges[i].End   = size_t(std::min(std::max(last + 1, 0.0), double(m_NumPoints)));
+        m_Ranges[i].End   = std::max(m_Ranges[i].Begin, m_Ranges[i].End);
+    }
+
+    // sample indices of the previous scan are meaningless in the new one
+    if (m_DeltaWavelength > 0)
+        m_TrackingHalfWidthPoints = size_t(std::ceil(m_TrackingHalfWidth / m_DeltaWavelength));
+    ResetTracking();
+}
+
+bool SpectrumPeakDetector::IsScanSet(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels) const
+{
+    return (
+        m_StartWavelength == startWavelength
+        && m_DeltaWavelength == deltaWavelength
+        && m_NumPoints == numPoints
+        && m_NumChannels == numChannels
+    );
+}
+
+void SpectrumPeakDetector::Detect(const double* spectrum)
+{
+    if (m_ChannelTasks.empty())
+        return;
+
+    m_Spectrum = spectrum;
+
+    if (m_Workers.empty())
+    {
+        for (const ChannelTask& task : m_ChannelTasks)
+            DetectChannel(task);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_NextTask   = 0;
+        m_NumPending = m_ChannelTasks.size();
+        m_Generation++;
+    }
+    m_WorkCondition.notify_all();
+
+    ProcessChannels();
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_DoneCondition.wait(lock, [this] { return m_NumPending == 0; });
+}
+
+void SpectrumPeakDetector::DetectChannel(const ChannelTask& task)
+{
+    if (task.Channel < 1 || task.Channel > m_NumChannels)
+    {
+        for (size_t windowIndex : task.WindowIndices)
+            DetectWindow(nullptr, windowIndex);
+
+        return;
+    }
+
+    const double* channelSpectrum = m_Spectrum + (task.Channel - 1) * m_NumPoints;
+    for (size_t windowIndex : task.WindowIndices)
+        DetectWindow(channelSpectrum, windowIndex);
+}
+
+void SpectrumPeakDetector::DetectWindow(const double* channelSpectrum, const size_t windowIndex)
+{
+    const WindowRange& range = m_Ranges[windowIndex];
+    SpectrumPeak&      peak  = m_Peaks[windowIndex];
+
+    peak.Valid      = false;
+    peak.Wavelength = std::numeric_limits<double>::quiet_NaN();
+    peak.Amplitude  = std::numeric_limits<double>::quiet_NaN();
+    peak.FWHM       = std::numeric_limits<double>::quiet_NaN();
+    peak.SNR        = std::numeric_limits<double>::quiet_NaN();
+    peak.Asymmetry  = std::numeric_limits<double>::quiet_NaN();
+
+    PeakTrack& track = m_Tracks[windowIndex];
+
+    if (!channelSpectrum || range.End <= range.Begin)
+    {
+        track.Locked = false;
+        return;
+    }
+
+    size_t maxIndex  = range.Begin;
+    double maxValue  = -std::numeric_limits<double>::infinity();
+    bool   searched  = false;
+
+    if (m_TrackingEnabled && track.Locked)
+    {
+        // narrow search around the previous peak, clipped to the window
+        size_t begin = std::max(range.Begin, track.Index - std::min(track.Index, m_TrackingHalfWidthPoints));
+        size_t end   = std::min(range.End, track.Index + m_TrackingHalfWidthPoints + 1);
+
+        maxValue = FindMaximum(channelSpectrum, begin, end, maxIndex);
+
+        // a maximum on an edge that is not also the window's edge means the FBG moved out of the narrow range
+        bool onEdge = (maxIndex == begin && begin > range.Begin) || (maxIndex + 1 == end && end < range.End);
+        searched    = maxValue >= m_Threshold && !onEdge;
+
+        if (!searched)
+            track.NumReacquisitions++;
+    }
+
+    if (!searched)
+        maxValue = FindMaximum(channelSpectrum, range.Begin, range.End, maxIndex);
+
+    if (!(maxValue >= m_Threshold))
+    {
+        track.Locked = false;
+        return;
+    }
+
+    track.Locked = true;
+    track.Index  = maxIndex;
+
+    double amplitude   = maxValue;
+    double peakIndex   = FitPeak(channelSpectrum, range.Begin, range.End, maxIndex, amplitude);
+
+    peak.Index      = maxIndex;
+    peak.Wavelength = m_StartWavelength + m_DeltaWavelength * peakIndex;
+    peak.Amplitude  = amplitude;
+    peak.Valid      = true;
+
+    MeasureQuality(channelSpectrum, range, peakIndex, peak);
+}
+
+void SpectrumPeakDetector::MeasureQuality(const double* channelSpectrum, const WindowRange& range, const double peakIndex, SpectrumPeak& peak) const
+{
+    // noise floor from the average linear power at both ends of the window
+    size_t numNoise = std::min(m_NoiseSamples, (range.End - range.Begin) / 4);
+    if (numNoise > 0)
+    {
+        double noisePower = 0.0;
+        for (size_t i = 0; i < numNoise; i++)
+        {
+            noisePower += std::pow(10.0, 0.1 * channelSpectrum[range.Begin + i]);
+            noisePower += std::pow(10.0, 0.1 * channelSpectrum[range.End - 1 - i]);
+        }
+        peak.SNR = peak.Amplitude - 10.0 * std::log10(noisePower / (2 * numNoise));
+    }
+
+    // -3 dB crossings, linearly interpolated between the samples that straddle them
+    double level = channelSpectrum[peak.Index] - 10.0 * std::log10(2.0);
+
+    size_t left = peak.Index;
+    while (left > range.Begin && channelSpectrum[left - 1] > level)
+        left--;
+
+    size_t right = peak.Index;
+    while (right + 1 < range.End && channelSpectrum[right + 1] > level)
+        right++;
+
+    // the peak is not resolved within the window
+    if (left == range.Begin || right + 1 == range.End)
+        return;
+
+    double leftCrossing  = double(left) - (channelSpectrum[left] - level) / (channelSpectrum[left] - channelSpectrum[left - 1]);
+    double rightCrossing = double(right) + (channelSpectrum[right] - level) / (channelSpectrum[right] - channelSpectrum[right + 1]);
+    double width         = rightCrossing - leftCrossing;
+
+    peak.FWHM      = width * m_DeltaWavelength;
+    peak.Asymmetry = ((rightCrossing - peakIndex) - (peakIndex - leftCrossing)) / width;
+}
+
+double SpectrumPeakDetector::FindMaximum(const double* channelSpectrum, const size_t begin, const size_t end, size_t& maxIndex) const
+{
+    // branch-free maximum so the scan over the range vectorizes
+    double maxValue = -std::numeric_limits<double>::infinity();
+    for (size_t i = begin; i < end; i++)
+        maxValue = channelSpectrum[i] > maxValue ? channelSpectrum[i] : maxValue;
+
+    maxIndex = begin;
+    while (maxIndex < end && channelSpectrum[maxIndex] != maxValue)
+        maxIndex++;
+
+    return maxValue;
+}
+
+double SpectrumPeakDetector::FitPeak(const double* channelSpectrum, const size_t begin, const size_t end, const size_t maxIndex, double& amplitude) const
+{
+    if (m_FitMethod == FitMethod::CENTROID)
+    {
+        // contiguous samples within m_CentroidLevel dB of the maximum
+        double level = channelSpectrum[maxIndex] - m_CentroidLevel;
+        size_t first = maxIndex, last = maxIndex;
+        while (first > begin && channelSpectrum[first - 1] >= level)
+            first--;
+        while (last + 1 < end && channelSpectrum[last + 1] >= level)
+            last++;
+
+        double sumWeights = 0.0, sumIndices = 0.0;
+        for (size_t i = first; i <= last; i++)
+        {
+            double weight = std::pow(10.0, 0.1 * (channelSpectrum[i] - channelSpectrum[maxIndex]));
+            sumWeights += weight;
+            sumIndices += weight * (double(i) - double(maxIndex));
+        }
+
+        return double(maxIndex) + sumIndices / sumWeights;
+    }
+
+    // three-point fits need a neighbour on both sides
+    if (maxIndex == begin || maxIndex + 1 >= end)
+        return double(maxIndex);
+
+    double y0 = channelSpectrum[maxIndex - 1];
+    double y1 = channelSpectrum[maxIndex];
+    double y2 = channelSpectrum[maxIndex + 1];
+
+    if (m_FitMethod == FitMethod::PARABOLIC)
+    {
+        y0 = std::pow(10.0, 0.1 * (y0 - y1));
+        y2 = std::pow(10.0, 0.1 * (y2 - y1));
+        y1 = 1.0;
+    }
+
+    double curvature = y0 - 2.0 * y1 + y2;
+    if (curvature >= 0.0)
+        return double(maxIndex);
+
+    double offset = 0.5 * (y0 - y2) / curvature;
+    double vertex = y1 - 0.25 * (y0 - y2) * offset;
+
+    if (m_FitMethod == FitMethod::PARABOLIC)
+        amplitude += 10.0 * std::log10(vertex);
+    else
+        amplitude = vertex;
+
+    return double(maxIndex) + offset;
+}
+
+void SpectrumPeakDetector::ProcessChannels()
+{
+    size_t taskIndex;
+    while ((taskIndex = m_NextTask.fetch_add(1)) < m_ChannelTasks.size())
+    {
+        DetectChannel(m_ChannelTasks[taskIndex]);
+
+        if (m_NumPending.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_DoneCondition.notify_all();
+        }
+    }
+}
+
+void SpectrumPeakDetector::WorkerLoop()
+{
+    size_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        generation = m_Generation;
+    }
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkCondition.wait(lock, [&] { return m_Stop || m_Generation != generation; });
+            if (m_Stop)
+                return;
+
+            generation = m_Generation;
+        }
+
+        ProcessChannels();
+    }
+}
+
+void SpectrumPeakDetector::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkCondition.notify_all();
+
+    for (std::thread& worker : m_Workers)
+        worker.join();
+
+    m_Workers.clear();
+}
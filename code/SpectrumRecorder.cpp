@@ -0,0 +1,349 @@
+#include "mtsFBGSensor/SpectrumProcessing/SpectrumRecorder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const char     RECORDING_MAGIC[8]     = "FBGSPEC";
+    const uint32_t RECORDING_VERSION      = 1;
+    const char     RECORDING_INDEX_FILE[] = "spectra.index";
+
+    std::string ChannelFileName(const std::string& directory, const size_t channel)
+    {
+        return directory + "/channel_" + std::to_string(channel) + ".raw";
+    }
+
+    std::string SystemError(const std::string& what, const std::string& path)
+    {
+        return what + " \"" + path + "\": " + std::strerror(errno);
+    }
+
+} // namespace
+
+void SpectrumMappedFile::Map(const std::string& path, const size_t size, const bool writable)
+{
+    Unmap();
+
+    m_FileDescriptor = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+    if (m_FileDescriptor < 0)
+        throw std::runtime_error(SystemError("Failed to open", path));
+
+    m_Size = size;
+    if (writable)
+    {
+        // reserve the blocks up front so page faults in the writer never extend the file
+        int result = ::posix_fallocate(m_FileDescriptor, 0, m_Size);
+        if (result != 0 && ::ftruncate(m_FileDescriptor, m_Size) != 0)
+        {
+            Unmap();
+            throw std::runtime_error(SystemError("Failed to preallocate", path));
+        }
+    }
+    else
+    {
+        struct stat fileStat;
+        if (::fstat(m_FileDescriptor, &fileStat) != 0)
+        {
+            Unmap();
+            throw std::runtime_error(SystemError("Failed to stat", path));
+        }
+        m_Size = size_t(fileStat.st_size);
+    }
+
+    if (m_Size == 0)
+        return;
+
+    void* data = ::mmap(
+        nullptr,
+        m_Size,
+        writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+        MAP_SHARED,
+        m_FileDescriptor,
+        0
+    );
+    if (data == MAP_FAILED)
+    {
+        Unmap();
+        throw std::runtime_error(SystemError("Failed to map", path));
+    }
+
+    m_Data = static_cast<uint8_t*>(data);
+    ::madvise(m_Data, m_Size, MADV_SEQUENTIAL);
+}
+
+void SpectrumMappedFile::Unmap()
+{
+    if (m_Data)
+        ::munmap(m_Data, m_Size);
+
+    if (m_FileDescriptor >= 0)
+        ::close(m_FileDescriptor);
+
+    m_Data           = nullptr;
+    m_Size           = 0;
+    m_FileDescriptor = -1;
+}
+
+SpectrumRecorder::~SpectrumRecorder()
+{
+    Close();
+}
+
+void SpectrumRecorder::Configure(const Json::Value& jsonConfig)
+{
+    m_Enabled = jsonConfig.get("Enabled", true).asBool();
+
+    if (jsonConfig.isMember("Directory"))
+        m_Directory = jsonConfig["Directory"].asString();
+
+    if (jsonConfig.isMember("Max_Sweeps"))
+        m_MaxSweeps = jsonConfig["Max_Sweeps"].asUInt64();
+
+    if (jsonConfig.isMember("Queue_Size"))
+        m_QueueSize = std::max(jsonConfig["Queue_Size"].asUInt(), 1u);
+}
+
+void SpectrumRecorder::Open(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels)
+{
+    try
+    {
+        OpenFiles(startWavelength, deltaWavelength, numPoints, numChannels);
+    }
+    catch(const std::runtime_error&)
+    {
+        // do not retry on every sweep
+        Close();
+        m_Enabled = false;
+        throw;
+    }
+
+    m_Queue.resize(m_QueueSize);
+    for (QueuedSweep& sweep : m_Queue)
+        sweep.Samples.resize(numChannels * numPoints);
+
+    m_QueueHead   = 0;
+    m_QueueTail   = 0;
+    m_NumRecorded = 0;
+    m_NumDropped  = 0;
+    m_Stop        = false;
+
+    m_Writer = std::thread(&SpectrumRecorder::WriterLoop, this);
+}
+
+void SpectrumRecorder::OpenFiles(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels)
+{
+    Close();
+
+    // every recording gets its own directory so a scan change never overwrites earlier sweeps
+    char timeString[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(timeString, sizeof(timeString), "%Y%m%d_%H%M%S", std::localtime(&now));
+
+    std::string directory = m_Directory + "/spectra_" + timeString;
+    for (int suffix = 1; ::mkdir(directory.c_str(), 0755) != 0; suffix++)
+    {
+        if (errno != EEXIST || suffix > 100)
+            throw std::runtime_error(SystemError("Failed to create", directory));
+
+        directory = m_Directory + "/spectra_" + timeString + "_" + std::to_string(suffix);
+    }
+
+    m_IndexFile.Map(
+        directory + "/" + RECORDING_INDEX_FILE,
+        sizeof(SpectrumRecordingHeader) + m_MaxSweeps * sizeof(SpectrumRecordingEntry),
+        true
+    );
+    m_Header  = reinterpret_cast<SpectrumRecordingHeader*>(m_IndexFile.GetData());
+    m_Entries = reinterpret_cast<SpectrumRecordingEntry*>(m_IndexFile.GetData() + sizeof(SpectrumRecordingHeader));
+
+    std::memcpy(m_Header->Magic, RECORDING_MAGIC, sizeof(m_Header->Magic));
+    m_Header->Version             = RECORDING_VERSION;
+    m_Header->NumChannels         = uint32_t(numChannels);
+    m_Header->NumPoints           = uint32_t(numPoints);
+    m_Header->Reserved            = 0;
+    m_Header->MaxSweeps           = m_MaxSweeps;
+    m_Header->NumSweeps           = 0;
+    m_Header->StartWavelength     = startWavelength;
+    m_Header->WavelengthIncrement = deltaWavelength;
+
+    m_ChannelFiles.clear();
+    for (size_t channel = 1; channel <= numChannels; channel++)
+    {
+        m_ChannelFiles.emplace_back(new SpectrumMappedFile());
+        m_ChannelFiles.back()->Map(ChannelFileName(directory, channel), m_MaxSweeps * numPoints * sizeof(uint16_t), true);
+    }
+
+    m_RecordingDirectory = directory;
+}
+
+bool SpectrumRecorder::IsScanSet(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels) const
+{
+    return (
+        m_Header
+        && m_Header->StartWavelength == startWavelength
+        && m_Header->WavelengthIncrement == deltaWavelength
+        && m_Header->NumPoints == numPoints
+        && m_Header->NumChannels == numChannels
+    );
+}
+
+void SpectrumRecorder::Close()
+{
+    if (m_Writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_QueueCondition.notify_all();
+        m_Writer.join();
+    }
+
+    m_ChannelFiles.clear();
+    m_IndexFile.Unmap();
+    m_Header  = nullptr;
+    m_Entries = nullptr;
+}
+
+bool SpectrumRecorder::Record(const uint64_t serialNumber, const double timestamp, const uint16_t* rawSpectrum)
+{
+    if (!IsOpen())
+        return false;
+
+    size_t head = m_QueueHead.load(std::memory_order_relaxed);
+    size_t tail = m_QueueTail.load(std::memory_order_acquire);
+
+    if (head - tail >= m_Queue.size() || m_NumRecorded + (head - tail) >= m_MaxSweeps)
+    {
+        m_NumDropped++;
+        return false;
+    }
+
+    QueuedSweep& sweep = m_Queue[head % m_Queue.size()];
+    sweep.Entry = {serialNumber, timestamp};
+    std::memcpy(sweep.Samples.data(), rawSpectrum, sweep.Samples.size() * sizeof(uint16_t));
+
+    m_QueueHead.store(head + 1, std::memory_order_release);
+    m_QueueCondition.notify_one();
+
+    return true;
+}
+
+void SpectrumRecorder::WriterLoop()
+{
+    while (true)
+    {
+        size_t tail = m_QueueTail.load(std::memory_order_relaxed);
+        if (tail == m_QueueHead.load(std::memory_order_acquire))
+        {
+            // the queue is flushed before stopping
+            if (m_Stop)
+                return;
+
+            // Record() does not take the lock, so the timeout bounds a missed notification
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_QueueCondition.wait_for(
+                lock,
+                std::chrono::milliseconds(10),
+                [&] { return m_Stop || m_QueueHead.load(std::memory_order_acquire) != tail; }
+            );
+            continue;
+        }
+
+        WriteSweep(m_Queue[tail % m_Queue.size()]);
+        m_QueueTail.store(tail + 1, std::memory_order_release);
+    }
+}
+
+void SpectrumRecorder::WriteSweep(const QueuedSweep& sweep)
+{
+    size_t sweepIndex = m_Header->NumSweeps;
+    size_t numPoints  = m_Header->NumPoints;
+
+    for (size_t channel = 0; channel < m_ChannelFiles.size(); channel++)
+    {
+        std::memcpy(
+            m_ChannelFiles[channel]->GetData() + sweepIndex * numPoints * sizeof(uint16_t),
+            sweep.Samples.data() + channel * numPoints,
+            numPoints * sizeof(uint16_t)
+        );
+    }
+    m_Entries[sweepIndex] = sweep.Entry;
+
+    // a reader never sees a sweep count ahead of the data
+    std::atomic_thread_fence(std::memory_order_release);
+    m_Header->NumSweeps = sweepIndex + 1;
+
+    m_NumRecorded++;
+}
+
+void SpectrumRecordingReader::Open(const std::string& directory)
+{
+    Close();
+
+    std::string indexPath = directory + "/" + RECORDING_INDEX_FILE;
+    m_IndexFile.Map(indexPath, 0, false);
+
+    m_Header  = reinterpret_cast<const SpectrumRecordingHeader*>(m_IndexFile.GetData());
+    m_Entries = reinterpret_cast<const SpectrumRecordingEntry*>(m_IndexFile.GetData() + sizeof(SpectrumRecordingHeader));
+
+    if (
+        m_IndexFile.GetSize() < sizeof(SpectrumRecordingHeader)
+        || std::memcmp(m_Header->Magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0
+        || m_Header->Version != RECORDING_VERSION
+        || m_IndexFile.GetSize() < sizeof(SpectrumRecordingHeader) + m_Header->MaxSweeps * sizeof(SpectrumRecordingEntry)
+    )
+    {
+        Close();
+        throw std::runtime_error("\"" + indexPath + "\" is not a spectrum recording index");
+    }
+
+    for (size_t channel = 1; channel <= m_Header->NumChannels; channel++)
+    {
+        std::string channelPath = ChannelFileName(directory, channel);
+
+        m_ChannelFiles.emplace_back(new SpectrumMappedFile());
+        m_ChannelFiles.back()->Map(channelPath, 0, false);
+
+        if (m_ChannelFiles.back()->GetSize() < m_Header->MaxSweeps * m_Header->NumPoints * sizeof(uint16_t))
+        {
+            Close();
+            throw std::runtime_error("\"" + channelPath + "\" is shorter than its recording index");
+        }
+    }
+}
+
+void SpectrumRecordingReader::Close()
+{
+    m_ChannelFiles.clear();
+    m_IndexFile.Unmap();
+    m_Header  = nullptr;
+    m_Entries = nullptr;
+}
+
+const uint16_t* SpectrumRecordingReader::GetChannel(const size_t channel) const
+{
+    if (channel < 1 || channel > m_ChannelFiles.size())
+        return nullptr;
+
+    return reinterpret_cast<const uint16_t*>(m_ChannelFiles[channel - 1]->GetData());
+}
+
+const uint16_t* SpectrumRecordingReader::GetSpectrum(const size_t sweep, const size_t channel) const
+{
+    const uint16_t* channelData = GetChannel(channel);
+    if (!channelData || sweep >= GetNumberOfSweeps())
+        return nullptr;
+
+    return channelData + sweep * m_Header->NumPoints;
+}
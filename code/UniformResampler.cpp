@@ -0,0 +1,146 @@
+#include "mtsFBGSensor/SensorFilters/UniformResampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <cisstCommon/cmnLogger.h>
+
+void UniformResampler::Configure(const Json::Value& jsonConfig)
+{
+    m_Enabled = jsonConfig.get("Enabled", true).asBool();
+
+    if (jsonConfig.isMember("Rate") && jsonConfig["Rate"].asDouble() > 0)
+        m_Period = 1.0 / jsonConfig["Rate"].asDouble();
+
+    // defaults scale with the period
+    m_MaxGap   = jsonConfig.get("Max_Gap",   2.5 * m_Period).asDouble();
+    m_ResetGap = jsonConfig.get("Reset_Gap", 100.0 * m_Period).asDouble();
+
+    if (jsonConfig.isMember("Method"))
+    {
+        std::string method = jsonConfig["Method"].asString();
+        std::transform(
+            method.begin(),
+            method.end(),
+            method.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+
+        if (method == "LINEAR")
+            m_Method = Method::LINEAR;
+
+        else if (method == "CUBIC")
+            m_Method = Method::CUBIC;
+
+        else
+            CMN_LOG_INIT_ERROR << "UniformResampler: invalid \"Method\" \"" << method
+                               << "\", using \"LINEAR\"" << std::endl;
+    }
+
+    Reset();
+}
+
+void UniformResampler::Reset()
+{
+    m_Inputs.clear();
+    m_HasGrid    = false;
+    m_NumOutputs = 0;
+}
+
+bool UniformResampler::AddSample(const double time, const vctDoubleVec& values)
+{
+    if (std::isnan(time) || (!m_Inputs.empty() && time <= m_Inputs.back().Time))
+        return false;
+
+    // a stall or a change of layout restarts the grid at the new sample
+    if (
+        !m_Inputs.empty()
+        && (time - m_Inputs.back().Time > m_ResetGap || values.size() != m_Inputs.back().Values.size())
+    )
+    {
+        m_Inputs.clear();
+        m_HasGrid = false;
+    }
+
+    m_Inputs.push_back({time, values});
+    if (!m_HasGrid)
+    {
+        m_NextTime = time;
+        m_HasGrid  = true;
+    }
+
+    // cubic needs a sample on either side of the bracketing interval
+    size_t lookAhead = m_Method == Method::CUBIC ? 1 : 0;
+    while (m_Inputs.size() >= 2 + lookAhead && m_Inputs[m_Inputs.size() - 1 - lookAhead].Time >= m_NextTime)
+    {
+        // keep one sample before the bracketing interval for the cubic slopes
+        while (m_Inputs.size() > 2 && m_Inputs[2].Time <= m_NextTime)
+            m_Inputs.pop_front();
+
+        if (m_NumOutputs == m_Outputs.size())
+            m_Outputs.emplace_back();
+
+        UniformSample& sample = m_Outputs[m_NumOutputs++];
+        Interpolate(m_NextTime, sample);
+        if (sample.IsGap)
+            m_NumGapSamples++;
+
+        m_NextTime += m_Period;
+    }
+
+    return true;
+}
+
+const std::vector<UniformSample>& UniformResampler::GetUniformSamples()
+{
+    m_Outputs.resize(m_NumOutputs);
+    m_NumOutputs = 0;
+
+    return m_Outputs;
+}
+
+void UniformResampler::Interpolate(const double time, UniformSample& sample) const
+{
+    // bracketing input samples i1 <= time <= i2
+    size_t i2 = 1;
+    while (i2 + 1 < m_Inputs.size() && m_Inputs[i2].Time < time)
+        i2++;
+    size_t i1 = i2 - 1;
+
+    const InputSample& p1 = m_Inputs[i1];
+    const InputSample& p2 = m_Inputs[i2];
+
+    double interval = p2.Time - p1.Time;
+    double u        = (time - p1.Time) / interval;
+
+    sample.Time  = time;
+    sample.IsGap = interval > m_MaxGap;
+    sample.Values.SetSize(p1.Values.size());
+
+    bool cubic = m_Method == Method::CUBIC && i1 > 0 && i2 + 1 < m_Inputs.size() && !sample.IsGap;
+    if (!cubic)
+    {
+        for (size_t i = 0; i < sample.Values.size(); i++)
+            sample.Values[i] = (1.0 - u) * p1.Values[i] + u * p2.Values[i];
+        return;
+    }
+
+    // cubic Hermite with finite difference slopes on the actual sample times
+    const InputSample& p0 = m_Inputs[i1 - 1];
+    const InputSample& p3 = m_Inputs[i2 + 1];
+
+    double u2  = u * u;
+    double u3  = u2 * u;
+    double h00 = 2 * u3 - 3 * u2 + 1;
+    double h10 = u3 - 2 * u2 + u;
+    double h01 = -2 * u3 + 3 * u2;
+    double h11 = u3 - u2;
+
+    for (size_t i = 0; i < sample.Values.size(); i++)
+    {
+        double m1 = (p2.Values[i] - p0.Values[i]) / (p2.Time - p0.Time);
+        double m2 = (p3.Values[i] - p1.Values[i]) / (p3.Time - p1.Time);
+
+        sample.Values[i] = h00 * p1.Values[i] + h10 * interval * m1 + h01 * p2.Values[i] + h11 * interval * m2;
+    }
+}
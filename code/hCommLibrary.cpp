@@ -30,6 +30,8 @@
 #include <arpa/inet.h>
 #include <cmath>
 #include <fcntl.h>
+#include <errno.h>
+#include <algorithm>
 #elif defined __APPLE__
 //OS X
 #include <sys/socket.h>
@@ -40,6 +42,9 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/select.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
 #endif
 
 
@@ -55,54 +60,116 @@
 const hResponse hComm::read_response()
 {
     hReadHeader readHeader;
-    int numRead;
-    char* message;
-    if (lastResponse.contentLength)
+    size_t frameLength;
+    const uint8_t* frame;
+    
+    fill_read_buffer(sizeof(readHeader));
+    memcpy(&readHeader, &readBuffer[readStart], sizeof(readHeader));
+    
+    //Wait for the complete frame, then parse the message and content out of the receive buffer
+    frameLength = sizeof(readHeader) + readHeader.messageLength + readHeader.contentLength;
+    fill_read_buffer(frameLength);
+    frame = &readBuffer[readStart + sizeof(readHeader)];
+    
+    lastResponse.contentLength = readHeader.contentLength;
+    lastResponse.messageLength = readHeader.messageLength;
+    lastResponse.message = std::string((const char*)frame, readHeader.messageLength);
+    
+    if (responseContent.size() < readHeader.contentLength)
     {
-        delete lastResponse.content;
-        lastResponse.contentLength = 0;
+        responseContent.resize(readHeader.contentLength);
     }
-    numRead = read_data(sizeof(readHeader), (uint8_t*)&readHeader);
-    if(numRead == -1)
+    if(readHeader.contentLength)
     {
-        throw HyperionException(this);
+        memcpy(responseContent.data(), frame + readHeader.messageLength, readHeader.contentLength);
     }
-    lastResponse.contentLength = readHeader.contentLength;
-    lastResponse.messageLength = readHeader.messageLength;
+    lastResponse.content = responseContent.data();
+    
+    readStart += frameLength;
     
-    if(readHeader.messageLength)
+    if (readHeader.status != H_SUCCESS)
     {
-        message = new char[readHeader.messageLength];
-        numRead = read_data(readHeader.messageLength, (uint8_t*)message);
-        if(numRead == -1)
-        {
-            throw HyperionException(this);
-        }
-        
-        lastResponse.message = std::string(message, numRead);
-        delete message;
+        throw HyperionException(readHeader.status, lastResponse.message);
     }
-    else
+    return lastResponse;
+    
+}
+
+int hComm::read_data(uint32_t numBytes, uint8_t* data)
+{
+    fill_read_buffer(numBytes);
+    memcpy(data, &readBuffer[readStart], numBytes);
+    readStart += numBytes;
+    return numBytes;
+}
+
+void hComm::reserve_read_buffer(size_t numBytes)
+{
+    size_t numBuffered = readEnd - readStart;
+    
+    if (numBuffered == 0)
+    {
+        readStart = readEnd = 0;
+    }
+    //Move the partial frame to the front once the tail gets too small for a full chunk
+    else if (readBuffer.size() - readEnd < std::max<size_t>(H_READ_CHUNK_SIZE, numBytes - numBuffered) && readStart > 0)
     {
-        lastResponse.message = "";
+        memmove(readBuffer.data(), &readBuffer[readStart], numBuffered);
+        readStart = 0;
+        readEnd = numBuffered;
     }
     
-    if(readHeader.contentLength)
+    if (readBuffer.size() < numBytes + H_READ_CHUNK_SIZE)
+    {
+        readBuffer.resize(std::max(2*readBuffer.size(), numBytes + H_READ_CHUNK_SIZE));
+    }
+}
+
+void hComm::fill_read_buffer(size_t numBytes)
+{
+    ssize_t returnVal;
+    while (readEnd - readStart < numBytes)
     {
-        lastResponse.content = new uint8_t[lastResponse.contentLength];
-        numRead = read_data(readHeader.contentLength, lastResponse.content);
+        reserve_read_buffer(numBytes);
+        returnVal = receive_data(&readBuffer[readEnd], readBuffer.size() - readEnd, true);
+        if (returnVal == -1)
+        {
+            throw HyperionException(this);
+        }
+        readEnd += returnVal;
     }
-    if(numRead == -1)
+}
+
+int hComm::poll_responses()
+{
+    ssize_t returnVal;
+    reserve_read_buffer(readEnd - readStart);
+    returnVal = receive_data(&readBuffer[readEnd], readBuffer.size() - readEnd, false);
+    if (returnVal == -1)
     {
         throw HyperionException(this);
     }
+    readEnd += returnVal;
+    return int(returnVal);
+}
+
+int hComm::get_num_buffered_responses() const
+{
+    hReadHeader readHeader;
+    size_t frameStart = readStart;
+    int numResponses = 0;
     
-    if (readHeader.status != H_SUCCESS)
+    while (readEnd - frameStart >= sizeof(readHeader))
     {
-        throw HyperionException(readHeader.status, lastResponse.message);
+        memcpy(&readHeader, &readBuffer[frameStart], sizeof(readHeader));
+        frameStart += sizeof(readHeader) + readHeader.messageLength + readHeader.contentLength;
+        if (frameStart > readEnd)
+        {
+            break;
+        }
+        numResponses++;
     }
-    return lastResponse;
-    
+    return numResponses;
 }
 
 const hResponse hComm::execute_command(std::string command, std::string argument, uint8_t requestOptions)
@@ -198,11 +265,6 @@ hCommTCPSocket::~hCommTCPSocket()
         close();
     }
     
-    if (lastResponse.contentLength)
-    {
-        delete lastResponse.content;
-    }
-    
 }
 
 void hCommTCPSocket::set_last_error(int errorNumber, std::string errorMessage)
@@ -381,24 +443,38 @@ int hCommTCPSocket::close()
     ::close(sockfd);
 #endif
     connected = false;
+    //Drop any partially received data so that a reconnect starts on a frame boundary
+    readStart = readEnd = 0;
     return 0;
 }
-int hCommTCPSocket::read_data(uint32_t numBytes, uint8_t* data)
+ssize_t hCommTCPSocket::receive_data(uint8_t* data, size_t maxBytes, bool wait)
 {
-    
-    int numRead = 0;
     ssize_t returnVal;
-    while (numRead != numBytes)
+#ifdef _WIN32
+    if (!wait)
     {
-        
-        returnVal = recv(sockfd, (char *)&data[numRead], numBytes - numRead, 0);
-        if (returnVal == -1)
+        u_long numPending = 0;
+        ioctlsocket(sockfd, FIONREAD, &numPending);
+        if (numPending == 0)
         {
-            return returnVal;
+            return 0;
         }
-        numRead += returnVal;
+        maxBytes = std::min<size_t>(maxBytes, numPending);
+    }
+    returnVal = recv(sockfd, (char *)data, int(maxBytes), 0);
+#else
+    returnVal = recv(sockfd, (char *)data, maxBytes, wait ? 0 : MSG_DONTWAIT);
+    if (returnVal == -1 && !wait && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        return 0;
     }
-    return numRead;
+#endif
+    if (returnVal == 0 && maxBytes > 0)
+    {
+        //Orderly shutdown by the instrument
+        throw HyperionException(-22001, "Connection closed by instrument.");
+    }
+    return returnVal;
 }
 
 int hCommTCPSocket::set_timeout(int timeout)
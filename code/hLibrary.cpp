@@ -45,6 +45,12 @@
 #include <sys/select.h>
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "mtsFBGSensor/hyperion/hLibrary.h"
 
 #ifdef _WIN32
@@ -97,11 +103,6 @@ Hyperion::~Hyperion()
         delete peakContent;
     }
     
-    if(spectrumContent != nullptr)
-    {
-        delete spectrumContent;
-    }
-    
     if(peakStreamComm != nullptr)
     {
         delete peakStreamComm;
@@ -122,7 +123,6 @@ void Hyperion::init()
     peakStreamComm = nullptr;
     spectrumStreamComm = nullptr;
     peakContent = nullptr;
-    spectrumContent = nullptr;
     calibrationOffset.clear();
     calibrationScale.clear();
     calibrationInvScale.clear();
@@ -149,6 +149,12 @@ void Hyperion::copy_response_content(uint8_t *copyBuffer)
     memcpy(copyBuffer, lastResponse.content, lastResponse.contentLength);
 }
 
+void Hyperion::copy_spectrum_content()
+{
+    spectrumContent.resize(lastResponse.contentLength);
+    copy_response_content(spectrumContent.get());
+}
+
 void Hyperion::get_user_data(int slot, uint8_t* userDataBuffer)
 {
     lastResponse = comm->execute_command("#GetUserData", std::to_string(slot), hREQUEST_OPT_SUPPRESS_MSG);
@@ -271,11 +277,9 @@ const hACQSpectrum Hyperion::get_spectrum(int numChannelsToReturn, int* channels
             channel = channelIndex;
         }
         int currentSpectrumBase = channel*spectrum.spectrumHeader->numPoints;
-        for(int spectrumIndex = 0; spectrumIndex < spectrum.spectrumHeader->numPoints; spectrumIndex++)
-        {
-            outputSpectrum[outputSpectrumIndex++] = double(spectrum.rawSpectrumData[currentSpectrumBase + spectrumIndex])*
-                calibrationInvScale[channel] + calibrationOffset[channel];
-        }
+        calibrate_spectrum(&spectrum.rawSpectrumData[currentSpectrumBase], spectrum.spectrumHeader->numPoints,
+                           calibrationInvScale[channel], calibrationOffset[channel], &outputSpectrum[outputSpectrumIndex]);
+        outputSpectrumIndex += spectrum.spectrumHeader->numPoints;
     }
 
     spectrum.calibratedSpectrumData.swap(outputSpectrum);
@@ -302,15 +306,10 @@ const hACQSpectrum Hyperion::get_raw_spectrum(int channel)
     
     lastResponse = comm->execute_command("#GetSpectrum", argument, hREQUEST_OPT_SUPPRESS_MSG);
     
-    if(spectrumContent != nullptr)
-    {
-        delete spectrumContent;
-    }
-    spectrumContent = new uint8_t[lastResponse.contentLength];
-    copy_response_content(spectrumContent);
-    rawSpectrum.spectrumHeader = (hACQSpectrumHeader*)spectrumContent;
+    copy_spectrum_content();
+    rawSpectrum.spectrumHeader = (hACQSpectrumHeader*)spectrumContent.get();
 
-    spectrumStart = (uint16_t *)(spectrumContent + sizeof(hACQSpectrumHeader));
+    spectrumStart = (uint16_t *)(spectrumContent.get() + sizeof(hACQSpectrumHeader));
     spectrumEnd = spectrumStart + rawSpectrum.spectrumHeader->numPoints*rawSpectrum.spectrumHeader->numChannels;
     
     std::vector<uint16_t> rawSpectrumData(spectrumStart, spectrumEnd);
@@ -322,6 +321,136 @@ const hACQSpectrum Hyperion::get_raw_spectrum(int channel)
 }
 
 
+const hSpectrumFrame& Hyperion::read_spectrum_frame(int outputs)
+{
+    if(spectrumStreamComm != nullptr && spectrumStreamComm->is_connected())
+    {
+        lastResponse = spectrumStreamComm->read_response();
+    }
+    else
+    {
+        lastResponse = comm->execute_command("#GetSpectrum", "", hREQUEST_OPT_SUPPRESS_MSG);
+    }
+    
+    //The raw samples stay in the comm's response buffer; only the header is copied
+    memcpy(&spectrumFrame.spectrumHeader, lastResponse.content, sizeof(hACQSpectrumHeader));
+    spectrumFrame.rawSpectrumData = (const uint16_t *)(lastResponse.content + sizeof(hACQSpectrumHeader));
+    spectrumFrame.calibratedSpectrumData = nullptr;
+    spectrumFrame.calibratedSpectrumDataFloat = nullptr;
+    
+    size_t numPoints = spectrumFrame.spectrumHeader.numPoints;
+    size_t numFrameChannels = std::min<size_t>(spectrumFrame.spectrumHeader.numChannels, calibrationInvScale.size());
+    spectrumFrame.numCalibratedChannels = numFrameChannels;
+    
+    if (outputs & H_SPECTRUM_DOUBLE)
+    {
+        calibratedSpectrum.resize(numFrameChannels*numPoints);
+        for(size_t channel = 0; channel < numFrameChannels; channel++)
+        {
+            calibrate_spectrum(spectrumFrame.rawSpectrumData + channel*numPoints, numPoints,
+                               calibrationInvScale[channel], calibrationOffset[channel],
+                               calibratedSpectrum.get() + channel*numPoints);
+        }
+        spectrumFrame.calibratedSpectrumData = calibratedSpectrum.get();
+    }
+    
+    if (outputs & H_SPECTRUM_FLOAT)
+    {
+        calibratedSpectrumFloat.resize(numFrameChannels*numPoints);
+        for(size_t channel = 0; channel < numFrameChannels; channel++)
+        {
+            calibrate_spectrum(spectrumFrame.rawSpectrumData + channel*numPoints, numPoints,
+                               float(calibrationInvScale[channel]), float(calibrationOffset[channel]),
+                               calibratedSpectrumFloat.get() + channel*numPoints);
+        }
+        spectrumFrame.calibratedSpectrumDataFloat = calibratedSpectrumFloat.get();
+    }
+    
+    return spectrumFrame;
+}
+
+void Hyperion::calibrate_spectrum(const uint16_t* rawSpectrum, size_t numSamples, double invScale, double offset, double* calibratedSpectrum)
+{
+    size_t index = 0;
+    
+#if defined(__AVX2__)
+    const __m256d scaleVector = _mm256_set1_pd(invScale);
+    const __m256d offsetVector = _mm256_set1_pd(offset);
+    for(; index + 8 <= numSamples; index += 8)
+    {
+        __m256i raw32 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(rawSpectrum + index)));
+        __m256d rawLow = _mm256_cvtepi32_pd(_mm256_castsi256_si128(raw32));
+        __m256d rawHigh = _mm256_cvtepi32_pd(_mm256_extracti128_si256(raw32, 1));
+#if defined(__FMA__)
+        _mm256_storeu_pd(calibratedSpectrum + index, _mm256_fmadd_pd(rawLow, scaleVector, offsetVector));
+        _mm256_storeu_pd(calibratedSpectrum + index + 4, _mm256_fmadd_pd(rawHigh, scaleVector, offsetVector));
+#else
+        _mm256_storeu_pd(calibratedSpectrum + index, _mm256_add_pd(_mm256_mul_pd(rawLow, scaleVector), offsetVector));
+        _mm256_storeu_pd(calibratedSpectrum + index + 4, _mm256_add_pd(_mm256_mul_pd(rawHigh, scaleVector), offsetVector));
+#endif
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float64x2_t scaleVector = vdupq_n_f64(invScale);
+    const float64x2_t offsetVector = vdupq_n_f64(offset);
+    for(; index + 8 <= numSamples; index += 8)
+    {
+        uint16x8_t raw16 = vld1q_u16(rawSpectrum + index);
+        uint32x4_t raw32[2] = {vmovl_u16(vget_low_u16(raw16)), vmovl_u16(vget_high_u16(raw16))};
+        for(int half = 0; half < 2; half++)
+        {
+            float64x2_t rawLow = vcvtq_f64_u64(vmovl_u32(vget_low_u32(raw32[half])));
+            float64x2_t rawHigh = vcvtq_f64_u64(vmovl_u32(vget_high_u32(raw32[half])));
+            vst1q_f64(calibratedSpectrum + index + 4*half, vfmaq_f64(offsetVector, rawLow, scaleVector));
+            vst1q_f64(calibratedSpectrum + index + 4*half + 2, vfmaq_f64(offsetVector, rawHigh, scaleVector));
+        }
+    }
+#endif
+    
+    for(; index < numSamples; index++)
+    {
+        calibratedSpectrum[index] = double(rawSpectrum[index])*invScale + offset;
+    }
+}
+
+void Hyperion::calibrate_spectrum(const uint16_t* rawSpectrum, size_t numSamples, float invScale, float offset, float* calibratedSpectrum)
+{
+    size_t index = 0;
+    
+#if defined(__AVX2__)
+    const __m256 scaleVector = _mm256_set1_ps(invScale);
+    const __m256 offsetVector = _mm256_set1_ps(offset);
+    for(; index + 16 <= numSamples; index += 16)
+    {
+        __m256i raw16 = _mm256_loadu_si256((const __m256i *)(rawSpectrum + index));
+        __m256 rawLow = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(raw16)));
+        __m256 rawHigh = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(raw16, 1)));
+#if defined(__FMA__)
+        _mm256_storeu_ps(calibratedSpectrum + index, _mm256_fmadd_ps(rawLow, scaleVector, offsetVector));
+        _mm256_storeu_ps(calibratedSpectrum + index + 8, _mm256_fmadd_ps(rawHigh, scaleVector, offsetVector));
+#else
+        _mm256_storeu_ps(calibratedSpectrum + index, _mm256_add_ps(_mm256_mul_ps(rawLow, scaleVector), offsetVector));
+        _mm256_storeu_ps(calibratedSpectrum + index + 8, _mm256_add_ps(_mm256_mul_ps(rawHigh, scaleVector), offsetVector));
+#endif
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t scaleVector = vdupq_n_f32(invScale);
+    const float32x4_t offsetVector = vdupq_n_f32(offset);
+    for(; index + 8 <= numSamples; index += 8)
+    {
+        uint16x8_t raw16 = vld1q_u16(rawSpectrum + index);
+        float32x4_t rawLow = vcvtq_f32_u32(vmovl_u16(vget_low_u16(raw16)));
+        float32x4_t rawHigh = vcvtq_f32_u32(vmovl_u16(vget_high_u16(raw16)));
+        vst1q_f32(calibratedSpectrum + index, vmlaq_f32(offsetVector, rawLow, scaleVector));
+        vst1q_f32(calibratedSpectrum + index + 4, vmlaq_f32(offsetVector, rawHigh, scaleVector));
+    }
+#endif
+    
+    for(; index < numSamples; index++)
+    {
+        calibratedSpectrum[index] = float(rawSpectrum[index])*invScale + offset;
+    }
+}
+
 void Hyperion::set_peak_stream_divider(int streamingDivider)
 {
 
@@ -364,12 +493,20 @@ const hACQPeaks Hyperion::stream_peaks()
 
 }
 
+int Hyperion::get_num_queued_peaks()
+{
+    peakStreamComm->poll_responses();
+    
+    return peakStreamComm->get_num_buffered_responses();
+}
+
 void Hyperion::disable_peak_streaming()
 {
     lastResponse = comm->execute_command("#DisablePeakDataStreaming","",hREQUEST_OPT_NONE);
     
     peakStreamComm->close();
     delete peakStreamComm;
+    peakStreamComm = nullptr;
 
     
 }
@@ -423,15 +560,10 @@ const hACQSpectrum Hyperion::stream_spectrum()
     
     lastResponse = spectrumStreamComm->read_response();
     
-    if(spectrumContent != nullptr)
-    {
-        delete spectrumContent;
-    }
-    spectrumContent = new uint8_t[lastResponse.contentLength];
-    copy_response_content(spectrumContent);
-    rawSpectrum.spectrumHeader = (hACQSpectrumHeader*)spectrumContent;
+    copy_spectrum_content();
+    rawSpectrum.spectrumHeader = (hACQSpectrumHeader*)spectrumContent.get();
     
-    uint16_t* spectrumStart = (uint16_t *)(spectrumContent + sizeof(hACQSpectrumHeader));
+    uint16_t* spectrumStart = (uint16_t *)(spectrumContent.get() + sizeof(hACQSpectrumHeader));
     uint16_t* spectrumEnd = spectrumStart + rawSpectrum.spectrumHeader->numPoints*rawSpectrum.spectrumHeader->numChannels;
     
     std::vector<uint16_t> rawSpectrumData(spectrumStart, spectrumEnd);
@@ -442,12 +574,20 @@ const hACQSpectrum Hyperion::stream_spectrum()
 
 }
 
+int Hyperion::get_num_queued_spectra()
+{
+    spectrumStreamComm->poll_responses();
+    
+    return spectrumStreamComm->get_num_buffered_responses();
+}
+
 void Hyperion::disable_spectrum_streaming()
 {
     lastResponse = comm->execute_command("#DisableFullSpectrumDataStreaming","",hREQUEST_OPT_NONE);
     
     spectrumStreamComm->close();
     delete spectrumStreamComm;
+    spectrumStreamComm = nullptr;
 
     
 }
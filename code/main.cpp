@@ -1,5 +1,6 @@
 #include "mtsFBGSensor/mtsFBGSensor/mtsFBGSensor.h"
 #include "mtsFBGSensor/mtsFBGTool/mtsFBGTool.h"
+#include "mtsFBGSensor/ROS/mtsFBGROSBatchPublisher.h"
 
 #include <memory>
 
@@ -21,6 +22,8 @@ int main(int argc, char* argv[])
     cmnCommandLineOptions options;
     std::string jsonFBGSensorConfigFile;
     std::string jsonFBGToolConfigFile;
+    double      batchPeriod = 10.0;    // ms
+    double      sampleRate  = 10000.0; // Hz
 
     options.AddOptionOneValue(
         "s", "json-config-sensor",
@@ -36,6 +39,23 @@ int main(int argc, char* argv[])
         &jsonFBGToolConfigFile
     );
 
+    options.AddOptionOneValue(
+        "b", "batch-period",
+        "Period of the batched sample topics in ms (default 10)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &batchPeriod
+    );
+
+    options.AddOptionOneValue(
+        "r", "sample-rate",
+        "Highest expected sensor sample rate in Hz, which sizes the batch queues (default 10000)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &sampleRate
+    );
+
+    if (!options.Parse(argc, argv, std::cerr))
+        return -1;
+
     // Configure tasks
     fbgSensorTask.Configure(jsonFBGSensorConfigFile);
     fbgToolTask.Configure(jsonFBGToolConfigFile); // FIXME: update to FBG tool's JSON config file
@@ -91,8 +111,30 @@ int main(int argc, char* argv[])
         "tool/name"
     );
 
+    // every sample, batched and stamped with its acquisition time
+    mtsFBGROSBatchPublisher batchPublisher("fbg_tool_ros_batch_publisher", batchPeriod * cmn_ms, sampleRate, &fbgNode);
+
+    batchPublisher.AddVectorBatch(
+        "RequiresFBGSensor",
+        "FBGPeaksSample",
+        "sensor/measured_wavelengths_batch"
+    );
+
+    batchPublisher.AddWrenchBatch(
+        "RequiresFBGTool",
+        "MeasuredCartesianForcesTipSample",
+        "tool/measured_forces_tip_cf_batch"
+    );
+
+    batchPublisher.AddWrenchBatch(
+        "RequiresFBGTool",
+        "MeasuredCartesianForcesScleraSample",
+        "tool/measured_forces_sclera_cf_batch"
+    );
+
     // Connect components
     manager->AddComponent(&rosBridge);
+    manager->AddComponent(&batchPublisher);
 
     manager->Connect(
         rosBridge.GetName(),     "RequiresFBGSensor",
@@ -104,6 +146,16 @@ int main(int argc, char* argv[])
         fbgToolTask.GetName(), "ProvidesFBGTool"
     );
 
+    manager->Connect(
+        batchPublisher.GetName(), "RequiresFBGSensor",
+        fbgSensorTask.GetName(),  "ProvidesFBGSensor"
+    );
+
+    manager->Connect(
+        batchPublisher.GetName(), "RequiresFBGTool",
+        fbgToolTask.GetName(),    "ProvidesFBGTool"
+    );
+
     // Spin 
     manager->CreateAllAndWait(2.0 * cmn_s);
     manager->StartAllAndWait(2.0 * cmn_s);
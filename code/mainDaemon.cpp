@@ -0,0 +1,169 @@
+#include "mtsFBGSensor/mtsFBGSensor/mtsFBGSensor.h"
+#include "mtsFBGSensor/mtsFBGTool/mtsFBGTool.h"
+#include "mtsFBGSensor/Streaming/FBGStreamServer.h"
+#include "mtsFBGSensor/Streaming/FBGMulticastPublisher.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include <signal.h>
+
+#include <cisstCommon/cmnUnits.h>
+#include <cisstMultiTask.h>
+
+/*
+ * Headless FBG sensor/tool pipeline without ROS: the sensor's peaks and the tool's force
+ * estimates are served to local clients over the stream socket (see FBGStreamServer) and,
+ * with a "Multicast" output, to remote hosts (see FBGMulticastPublisher) until SIGINT or SIGTERM.
+ */
+int main(int argc, char* argv[])
+{
+    // the tasks' threads inherit the blocked signals, so only sigwait() below receives them
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    // command line options
+    cmnCommandLineOptions options;
+    std::string jsonFBGSensorConfigFile;
+    std::string jsonFBGToolConfigFile;
+    std::string jsonOutputConfigFile;
+
+    options.AddOptionOneValue(
+        "s", "json-config-sensor",
+        "The FBG Sensor/interrogator's configuration",
+        cmnCommandLineOptions::REQUIRED_OPTION,
+        &jsonFBGSensorConfigFile
+    );
+
+    options.AddOptionOneValue(
+        "t", "json-config-tool",
+        "The FBG Tool's configuration (only the sensor's peaks are served without it)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &jsonFBGToolConfigFile
+    );
+
+    options.AddOptionOneValue(
+        "o", "json-config-output",
+        "The streaming outputs' configuration (default: local socket /tmp/fbg_sensor.sock)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &jsonOutputConfigFile
+    );
+
+    if (!options.Parse(argc, argv, std::cerr))
+        return -1;
+
+    // streaming outputs
+    FBGStreamServer       streamServer;
+    FBGMulticastPublisher multicastPublisher;
+    bool                  useMulticast = false;
+    if (!jsonOutputConfigFile.empty())
+    {
+        std::ifstream jsonStream(jsonOutputConfigFile.c_str());
+        Json::Value   jsonConfig;
+        Json::Reader  jsonReader;
+
+        if (!jsonReader.parse(jsonStream, jsonConfig))
+        {
+            std::cerr << "Failed to parse the output configuration file \"" << jsonOutputConfigFile << "\"" << std::endl
+                      << jsonReader.getFormattedErrorMessages();
+            return -1;
+        }
+
+        if (jsonConfig.isMember("Local_Socket"))
+            streamServer.Configure(jsonConfig["Local_Socket"]);
+
+        if (jsonConfig.isMember("Multicast"))
+        {
+            multicastPublisher.Configure(jsonConfig["Multicast"]);
+            useMulticast = jsonConfig["Multicast"].get("Enabled", true).asBool();
+        }
+    }
+
+    try
+    {
+        streamServer.Start();
+
+        if (useMulticast)
+            multicastPublisher.Open();
+    }
+    catch(const std::runtime_error& error)
+    {
+        std::cerr << error.what() << std::endl;
+        return -1;
+    }
+
+    // Configure tasks
+    mtsComponentManager* manager = mtsManagerLocal::GetInstance();
+
+    mtsFBGSensor fbgSensorTask("FBGSensorTask");
+    fbgSensorTask.Configure(jsonFBGSensorConfigFile);
+    manager->AddComponent(&fbgSensorTask);
+
+    // frames are handed over on the tasks' threads as soon as they are produced
+    fbgSensorTask.AddPeaksSubscriber(
+        [&streamServer, &multicastPublisher] (const FBGPeaksFrame& frame) {
+            streamServer.Push(FBGStream::STREAM_PEAKS, frame.Time, frame.Peaks.Pointer(), frame.Peaks.size());
+            multicastPublisher.Push(FBGStream::STREAM_PEAKS, frame.Time, frame.Peaks.Pointer(), frame.Peaks.size());
+        }
+    );
+
+    std::unique_ptr<mtsFBGTool> fbgToolTask;
+    if (!jsonFBGToolConfigFile.empty())
+    {
+        fbgToolTask.reset(new mtsFBGTool("FBGToolTask"));
+        fbgToolTask->Configure(jsonFBGToolConfigFile);
+        manager->AddComponent(fbgToolTask.get());
+
+        manager->Connect(
+            fbgToolTask->GetName(),  "RequiresFBGSensor",
+            fbgSensorTask.GetName(), "ProvidesFBGSensor"
+        );
+
+        fbgToolTask->AddEstimateSubscriber(
+            [&streamServer, &multicastPublisher] (const FBGForceEstimate& estimate) {
+                streamServer.Push(FBGStream::STREAM_FORCES_TIP,    estimate.Time, estimate.ForcesTip.Pointer(),    estimate.ForcesTip.size());
+                streamServer.Push(FBGStream::STREAM_FORCES_SCLERA, estimate.Time, estimate.ForcesSclera.Pointer(), estimate.ForcesSclera.size());
+
+                multicastPublisher.Push(FBGStream::STREAM_FORCES_TIP,    estimate.Time, estimate.ForcesTip.Pointer(),    estimate.ForcesTip.size());
+                multicastPublisher.Push(FBGStream::STREAM_FORCES_SCLERA, estimate.Time, estimate.ForcesSclera.Pointer(), estimate.ForcesSclera.size());
+            }
+        );
+    }
+
+    manager->CreateAllAndWait(2.0 * cmn_s);
+    manager->StartAllAndWait(2.0 * cmn_s);
+
+    std::cout << "Serving FBG streams on \"" << streamServer.GetSocketPath() << "\"" << std::endl;
+    if (multicastPublisher.IsOpen())
+        std::cout << "Publishing FBG streams by multicast" << std::endl;
+
+    int signal;
+    sigwait(&stopSignals, &signal);
+
+    manager->KillAllAndWait(2.0 * cmn_s);
+    manager->Cleanup();
+
+    streamServer.Stop();
+    std::cout << "Sent " << streamServer.GetNumberOfSentFrames()
+              << " frames, dropped " << streamServer.GetNumberOfDroppedFrames()
+              << ", skipped by slow clients " << streamServer.GetNumberOfSkippedFrames()
+              << std::endl;
+
+    if (multicastPublisher.IsOpen())
+    {
+        std::cout << "Multicast " << multicastPublisher.GetNumberOfSentFrames()
+                  << " frames, dropped " << multicastPublisher.GetNumberOfDroppedFrames()
+                  << std::endl;
+        multicastPublisher.Close();
+    }
+
+    cmnLogger::Kill();
+
+    return 0;
+
+}
@@ -0,0 +1,341 @@
+#include "mtsFBGSensor/SensorFilters/SignalEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cisstCommon/cmnCommandLineOptions.h>
+
+/*
+ * Offline comparison of the force estimators' delay and noise on recorded peaks.
+ *
+ * The recording is a text file with one frame per line: the time [s] followed by the peaks
+ * [nm], separated by commas or white space (e.g. "rostopic echo -p" output or a CSV export);
+ * lines that do not start with a number are skipped. Every estimator is run causally over the
+ * recording and compared with a zero-phase reference, the centered moving average of the
+ * peaks:
+ *
+ *   delay      lag of the reference that minimizes the residual (parabolic sub-sample refinement)
+ *   residual   RMS of the estimate minus the reference delayed by that lag
+ *   reduction  residual relative to the raw peaks' deviation from the reference
+ *
+ * Without an estimator configuration a default set (boxcars, Kalman filters, Butterworths) is compared.
+ */
+namespace
+{
+    struct Recording
+    {
+        std::vector<double>              Time;
+        std::vector<std::vector<double>> Signals; // one per peak
+    };
+
+    bool ReadRecording(const std::string& filename, Recording& recording)
+    {
+        std::ifstream file(filename.c_str());
+        if (!file)
+            return false;
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::replace(line.begin(), line.end(), ',', ' ');
+            std::istringstream stream(line);
+
+            std::vector<double> values;
+            double value;
+            while (stream >> value)
+                values.push_back(value);
+
+            // headers and frames of another size
+            if (values.size() < 2 || (!recording.Signals.empty() && values.size() - 1 != recording.Signals.size()))
+                continue;
+
+            if (recording.Signals.empty())
+                recording.Signals.resize(values.size() - 1);
+
+            recording.Time.push_back(values[0]);
+            for (size_t i = 1; i < values.size(); i++)
+                recording.Signals[i - 1].push_back(values[i]);
+        }
+
+        return !recording.Time.empty();
+    }
+
+    double MedianSamplePeriod(const std::vector<double>& time)
+    {
+        std::vector<double> periods;
+        for (size_t k = 1; k < time.size(); k++)
+        {
+            if (time[k] > time[k - 1])
+                periods.push_back(time[k] - time[k - 1]);
+        }
+
+        if (periods.empty())
+            return 1e-3;
+
+        std::nth_element(periods.begin(), periods.begin() + periods.size() / 2, periods.end());
+        return periods[periods.size() / 2];
+    }
+
+    std::vector<double> CenteredMovingAverage(const std::vector<double>& signal, const size_t window)
+    {
+        size_t half = window / 2;
+        std::vector<double> average(signal.size(), std::numeric_limits<double>::quiet_NaN());
+        if (signal.size() < window)
+            return average;
+
+        double sum = 0.0;
+        for (size_t k = 0; k < window; k++)
+            sum += signal[k];
+
+        for (size_t k = half; k + half < signal.size(); k++)
+        {
+            average[k] = sum / double(window);
+            if (k + half + 1 < signal.size())
+                sum += signal[k + half + 1] - signal[k - half];
+        }
+
+        return average;
+    }
+
+    struct Result
+    {
+        std::string Description;
+        double      Delay;       // [samples]
+        double      Residual;    // RMS [nm]
+        double      RawResidual; // RMS [nm]
+    };
+
+    Result Analyze(SignalEstimator& estimator, const Recording& recording, const std::vector<std::vector<double>>& references,
+                   const size_t skip, const size_t maxLag)
+    {
+        size_t numSamples = recording.Time.size();
+        size_t numSignals = recording.Signals.size();
+
+        // run the estimator causally over the recording
+        std::vector<std::vector<double>> estimates(numSignals, std::vector<double>(numSamples, std::numeric_limits<double>::quiet_NaN()));
+        vctDoubleVec sample(numSignals);
+
+        estimator.Reset();
+        for (size_t k = 0; k < numSamples; k++)
+        {
+            for (size_t i = 0; i < numSignals; i++)
+                sample[i] = recording.Signals[i][k];
+
+            if (!estimator.Update(recording.Time[k], sample))
+                continue;
+
+            for (size_t i = 0; i < numSignals; i++)
+                estimates[i][k] = estimator.GetEstimate()[i];
+        }
+
+        // squared residual against the reference delayed by each lag, pooled over the signals
+        // (the same samples for every lag, so the lags compare fairly)
+        std::vector<double> sumSquares(maxLag + 1, 0.0);
+        double sumRawSquares = 0.0;
+        size_t count         = 0;
+        for (size_t i = 0; i < numSignals; i++)
+        {
+            for (size_t k = skip + maxLag; k < numSamples; k++)
+            {
+                double rawResidual = recording.Signals[i][k] - references[i][k];
+                if (!std::isfinite(estimates[i][k]) || !std::isfinite(rawResidual))
+                    continue;
+
+                bool isValid = true;
+                for (size_t lag = 0; lag <= maxLag && isValid; lag++)
+                    isValid = std::isfinite(references[i][k - lag]);
+                if (!isValid)
+                    continue;
+
+                for (size_t lag = 0; lag <= maxLag; lag++)
+                {
+                    double residual = estimates[i][k] - references[i][k - lag];
+                    sumSquares[lag] += residual * residual;
+                }
+                sumRawSquares += rawResidual * rawResidual;
+                count++;
+            }
+        }
+
+        size_t best  = std::min_element(sumSquares.begin(), sumSquares.end()) - sumSquares.begin();
+        double delay = double(best);
+        if (best > 0 && best < maxLag)
+        {
+            double previous  = sumSquares[best - 1];
+            double next      = sumSquares[best + 1];
+            double curvature = previous - 2.0 * sumSquares[best] + next;
+            if (curvature > 0.0)
+                delay += 0.5 * (previous - next) / curvature;
+        }
+
+        Result result;
+        result.Description = estimator.GetDescription();
+        result.Delay       = delay;
+        result.Residual    = count > 0 ? std::sqrt(sumSquares[best] / count) : std::numeric_limits<double>::quiet_NaN();
+        result.RawResidual = count > 0 ? std::sqrt(sumRawSquares / count)    : std::numeric_limits<double>::quiet_NaN();
+        return result;
+    }
+
+    Json::Value DefaultEstimators(const double sampleRate, const double measurementNoise)
+    {
+        Json::Value estimators(Json::arrayValue);
+
+        for (unsigned int numSamples : {200u, 50u, 20u})
+        {
+            Json::Value boxcar;
+            boxcar["Type"]        = "Boxcar";
+            boxcar["Num_Samples"] = numSamples;
+            estimators.append(boxcar);
+        }
+
+        // constant velocity Kalman filters of about the given bandwidths: q = R dt w^4
+        for (double bandwidth : {10.0, 30.0})
+        {
+            double w = 2.0 * M_PI * bandwidth;
+
+            Json::Value kalman;
+            kalman["Type"]              = "Kalman";
+            kalman["Model"]             = "Constant_Velocity";
+            kalman["Measurement_Noise"] = measurementNoise;
+            kalman["Process_Noise"]     = measurementNoise / sampleRate * w * w * w * w;
+            kalman["Sample_Rate"]       = sampleRate;
+            estimators.append(kalman);
+        }
+
+        for (unsigned int order : {2u, 4u})
+        {
+            for (double cutoff : {10.0, 30.0})
+            {
+                Json::Value butterworth;
+                butterworth["Type"]             = "Butterworth";
+                butterworth["Order"]            = order;
+                butterworth["Cutoff_Frequency"] = cutoff;
+                butterworth["Sample_Rate"]      = sampleRate;
+                estimators.append(butterworth);
+            }
+        }
+
+        return estimators;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // command line options
+    cmnCommandLineOptions options;
+    std::string dataFile;
+    std::string jsonEstimatorsFile;
+    int         referenceWindow = 101;
+    int         maxLag          = 500;
+
+    options.AddOptionOneValue(
+        "d", "data",
+        "Recorded peaks: time [s] followed by the peaks [nm] on every line",
+        cmnCommandLineOptions::REQUIRED_OPTION,
+        &dataFile
+    );
+
+    options.AddOptionOneValue(
+        "e", "json-config-estimators",
+        "JSON array of \"Estimator\" blocks to compare (default: a set of boxcars, Kalman filters and Butterworths)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &jsonEstimatorsFile
+    );
+
+    options.AddOptionOneValue(
+        "w", "reference-window",
+        "Samples of the centered moving average used as reference (default 101)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &referenceWindow
+    );
+
+    options.AddOptionOneValue(
+        "l", "max-lag",
+        "Largest delay searched in samples (default 500)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &maxLag
+    );
+
+    if (!options.Parse(argc, argv, std::cerr))
+        return -1;
+
+    Recording recording;
+    if (!ReadRecording(dataFile, recording))
+    {
+        std::cerr << "Failed to read any frame from \"" << dataFile << "\"" << std::endl;
+        return -1;
+    }
+
+    double samplePeriod = MedianSamplePeriod(recording.Time);
+    size_t window       = size_t(std::max(referenceWindow, 1)) | 1; // odd, so it is centered
+
+    std::vector<std::vector<double>> references;
+    double sumSquares = 0.0;
+    size_t count      = 0;
+    for (const std::vector<double>& signal : recording.Signals)
+    {
+        references.push_back(CenteredMovingAverage(signal, window));
+        for (size_t k = 0; k < signal.size(); k++)
+        {
+            double residual = signal[k] - references.back()[k];
+            if (std::isfinite(residual))
+            {
+                sumSquares += residual * residual;
+                count++;
+            }
+        }
+    }
+    double measurementNoise = count > 0 ? sumSquares / count : 1e-6;
+
+    Json::Value jsonEstimators = DefaultEstimators(1.0 / samplePeriod, measurementNoise);
+    if (!jsonEstimatorsFile.empty())
+    {
+        std::ifstream jsonStream(jsonEstimatorsFile.c_str());
+        Json::Reader  jsonReader;
+        if (!jsonReader.parse(jsonStream, jsonEstimators) || !jsonEstimators.isArray())
+        {
+            std::cerr << "Failed to parse the estimators file \"" << jsonEstimatorsFile << "\" as a JSON array" << std::endl
+                      << jsonReader.getFormattedErrorMessages();
+            return -1;
+        }
+    }
+
+    // the longest boxcar's warm-up and the reference's edges are left out of every comparison
+    size_t skip = window;
+    for (const Json::Value& jsonEstimator : jsonEstimators)
+        skip = std::max<size_t>(skip, jsonEstimator.get("Num_Samples", 0).asUInt());
+
+    std::cout << recording.Time.size() << " frames of " << recording.Signals.size() << " peaks, "
+              << 1.0 / samplePeriod << " Hz, raw noise " << 1000.0 * std::sqrt(measurementNoise) << " pm RMS" << std::endl
+              << std::endl;
+
+    std::printf("%-50s %10s %10s %14s %14s\n", "Estimator", "Delay", "Delay", "Residual", "Reduction");
+    std::printf("%-50s %10s %10s %14s %14s\n", "",          "[samples]", "[ms]", "[pm RMS]", "[dB]");
+    for (const Json::Value& jsonEstimator : jsonEstimators)
+    {
+        SignalEstimator estimator;
+        estimator.Configure(jsonEstimator);
+        if (!estimator.IsEnabled())
+            continue;
+
+        Result result = Analyze(estimator, recording, references, skip, size_t(std::max(maxLag, 1)));
+        std::printf(
+            "%-50s %10.1f %10.2f %14.3f %14.1f\n",
+            result.Description.c_str(),
+            result.Delay,
+            1000.0 * result.Delay * samplePeriod,
+            1000.0 * result.Residual,
+            20.0 * std::log10(result.Residual / result.RawResidual)
+        );
+    }
+
+    return 0;
+}
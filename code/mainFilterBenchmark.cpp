@@ -0,0 +1,197 @@
+#include "mtsFBGSensor/SensorFilters/FilterBank.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cisstCommon/cmnCommandLineOptions.h>
+
+/*
+ * Throughput of the filter bank over the number of channels and the filter length.
+ *
+ * Every configuration filters the same pseudo-random samples one sample at a time, as the
+ * tool does, and reports the time per sample and the channel samples (and multiply-adds for
+ * FIR filters) per second. Without a filter configuration FIR filters, Butterworth cascades
+ * and a moving average are swept; with one, that filter block is timed for every channel count.
+ */
+namespace
+{
+    struct Timing
+    {
+        double NanosecondsPerSample;
+        double ChecksumSink; // keeps the filtering from being optimized away
+    };
+
+    Timing TimeFilter(FilterBank& filters, const size_t numChannels, const size_t numSamples)
+    {
+        // a block of input samples reused cyclically, so the input does not stream from memory
+        const size_t numInputs = 1024;
+        std::mt19937 generator(42);
+        std::normal_distribution<double> noise(1550.0, 0.002);
+        std::vector<double> inputs(numInputs * numChannels);
+        for (double& input : inputs)
+            input = noise(generator);
+
+        std::vector<double> output(numChannels);
+        filters.SetNumberOfChannels(numChannels);
+
+        // warm up the caches and the states
+        for (size_t k = 0; k < numInputs; k++)
+            filters.Process(inputs.data() + k * numChannels, output.data());
+
+        double checksum = 0.0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < numSamples; k++)
+        {
+            filters.Process(inputs.data() + (k % numInputs) * numChannels, output.data());
+            checksum += output[0];
+        }
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+        Timing timing;
+        timing.NanosecondsPerSample = std::chrono::duration<double, std::nano>(stop - start).count() / double(numSamples);
+        timing.ChecksumSink         = checksum;
+        return timing;
+    }
+
+    Json::Value MakeConfig(const Json::Value& stage)
+    {
+        Json::Value config;
+        config["Sample_Rate"] = 1000.0;
+        config["Stages"].append(stage);
+        return config;
+    }
+
+    void PrintRow(const std::string& description, const size_t numChannels, const size_t numTaps, const Timing& timing)
+    {
+        double samplesPerSecond = 1e9 / timing.NanosecondsPerSample;
+        std::printf(
+            "%-40s %9zu %12.1f %18.2f",
+            description.c_str(),
+            numChannels,
+            timing.NanosecondsPerSample,
+            1e-6 * samplesPerSecond * double(numChannels)
+        );
+        if (numTaps > 0)
+            std::printf(" %18.1f", 1e-6 * samplesPerSecond * double(numChannels * numTaps));
+        std::printf("\n");
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // command line options
+    cmnCommandLineOptions options;
+    std::string jsonFiltersFile;
+    int         numSamples = 100000;
+
+    options.AddOptionOneValue(
+        "f", "json-config-filters",
+        "A filter block (e.g. a tool's \"Wavelength_Filters\") to time instead of the default sweep",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &jsonFiltersFile
+    );
+
+    options.AddOptionOneValue(
+        "n", "num-samples",
+        "Samples filtered per configuration (default 100000)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &numSamples
+    );
+
+    if (!options.Parse(argc, argv, std::cerr))
+        return -1;
+
+    const std::vector<size_t> channelCounts = {1, 3, 9, 16, 32, 64, 128};
+    size_t samples = size_t(std::max(numSamples, 1));
+    double sink    = 0.0;
+
+    std::printf("%-40s %9s %12s %18s %18s\n", "Filter", "Channels", "Per sample", "Throughput", "FIR");
+    std::printf("%-40s %9s %12s %18s %18s\n", "",       "",         "[ns]",       "[M ch-samples/s]", "[M MAC/s]");
+
+    if (!jsonFiltersFile.empty())
+    {
+        std::ifstream jsonStream(jsonFiltersFile.c_str());
+        Json::Value   jsonConfig;
+        Json::Reader  jsonReader;
+        if (!jsonReader.parse(jsonStream, jsonConfig))
+        {
+            std::cerr << "Failed to parse the filters file \"" << jsonFiltersFile << "\"" << std::endl
+                      << jsonReader.getFormattedErrorMessages();
+            return -1;
+        }
+
+        FilterBank filters;
+        if (!filters.Configure(jsonConfig) || filters.GetNumberOfStages() == 0)
+        {
+            std::cerr << "The filters file \"" << jsonFiltersFile << "\" has no valid stages" << std::endl;
+            return -1;
+        }
+
+        for (size_t numChannels : channelCounts)
+        {
+            Timing timing = TimeFilter(filters, numChannels, samples);
+            PrintRow(filters.GetDescription(), numChannels, 0, timing);
+            sink += timing.ChecksumSink;
+        }
+    }
+    else
+    {
+        for (size_t numTaps : {8u, 32u, 128u, 512u})
+        {
+            Json::Value stage;
+            stage["Type"] = "FIR";
+            for (size_t k = 0; k < numTaps; k++)
+                stage["Taps"].append(1.0 / double(numTaps));
+
+            FilterBank filters;
+            filters.Configure(MakeConfig(stage));
+            for (size_t numChannels : channelCounts)
+            {
+                Timing timing = TimeFilter(filters, numChannels, samples);
+                PrintRow(filters.GetDescription(), numChannels, numTaps, timing);
+                sink += timing.ChecksumSink;
+            }
+        }
+
+        for (unsigned int order : {2u, 8u})
+        {
+            Json::Value stage;
+            stage["Type"]      = "Lowpass";
+            stage["Frequency"] = 20.0;
+            stage["Order"]     = order;
+
+            FilterBank filters;
+            filters.Configure(MakeConfig(stage));
+            for (size_t numChannels : channelCounts)
+            {
+                Timing timing = TimeFilter(filters, numChannels, samples);
+                PrintRow(filters.GetDescription(), numChannels, 0, timing);
+                sink += timing.ChecksumSink;
+            }
+        }
+
+        Json::Value stage;
+        stage["Type"]        = "Moving_Average";
+        stage["Num_Samples"] = 200;
+
+        FilterBank filters;
+        filters.Configure(MakeConfig(stage));
+        for (size_t numChannels : channelCounts)
+        {
+            Timing timing = TimeFilter(filters, numChannels, samples);
+            PrintRow(filters.GetDescription(), numChannels, 0, timing);
+            sink += timing.ChecksumSink;
+        }
+    }
+
+    // printed so the filtering cannot be optimized away
+    std::printf("\nchecksum %g\n", sink);
+    return 0;
+}
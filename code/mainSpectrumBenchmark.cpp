@@ -0,0 +1,182 @@
+#include "mtsFBGSensor/hyperion/hLibrary.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cisstCommon/cmnCommandLineOptions.h>
+
+/*
+ * Throughput of the spectrum calibration (raw samples to dBm) on full spectra.
+ *
+ * Every spectrum of the given channels and points is calibrated channel by channel, as
+ * Hyperion::read_spectrum_frame does, with Hyperion::calibrate_spectrum (the SIMD path this
+ * binary was compiled for, see mtsFBGSensor_NATIVE_ARCH) and with a plain loop (as far as
+ * the compiler vectorizes it by itself), as double and as float. The largest difference to
+ * the plain double loop is printed with every row.
+ */
+namespace
+{
+    // the SIMD path compiled into Hyperion::calibrate_spectrum
+#if defined(__AVX2__)
+    const char* SIMD_PATH = "AVX2";
+#elif defined(__ARM_NEON)
+    const char* SIMD_PATH = "NEON";
+#else
+    const char* SIMD_PATH = "scalar";
+#endif
+
+    struct Spectrum
+    {
+        size_t                NumChannels;
+        size_t                NumPoints;
+        std::vector<uint16_t> Raw;
+        std::vector<double>   InvScales;
+        std::vector<double>   Offsets;
+    };
+
+    template <typename T>
+    void CalibrateScalar(const uint16_t* raw, const size_t numSamples, const T invScale, const T offset, T* calibrated)
+    {
+        for (size_t i = 0; i < numSamples; i++)
+            calibrated[i] = T(raw[i]) * invScale + offset;
+    }
+
+    template <typename T>
+    void CalibrateLibrary(const uint16_t* raw, const size_t numSamples, const T invScale, const T offset, T* calibrated)
+    {
+        Hyperion::calibrate_spectrum(raw, numSamples, invScale, offset, calibrated);
+    }
+
+    // microseconds per spectrum, and the largest difference to the reference
+    template <typename T, typename Calibrate>
+    void TimeCalibration(
+        const std::string& description,
+        const Spectrum& spectrum,
+        const std::vector<double>& reference,
+        const size_t numSpectra,
+        Calibrate calibrate
+    )
+    {
+        std::vector<T> calibrated(spectrum.NumChannels * spectrum.NumPoints);
+
+        auto calibrateAll = [&] () {
+            for (size_t channel = 0; channel < spectrum.NumChannels; channel++)
+                calibrate(
+                    spectrum.Raw.data() + channel * spectrum.NumPoints,
+                    spectrum.NumPoints,
+                    T(spectrum.InvScales[channel]),
+                    T(spectrum.Offsets[channel]),
+                    calibrated.data() + channel * spectrum.NumPoints
+                );
+        };
+
+        // warm up the caches
+        calibrateAll();
+
+        double checksum = 0.0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < numSpectra; k++)
+        {
+            calibrateAll();
+            checksum += double(calibrated[k % calibrated.size()]);
+        }
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+        double maxError = 0.0;
+        for (size_t i = 0; i < calibrated.size(); i++)
+            maxError = std::max(maxError, std::abs(double(calibrated[i]) - reference[i]));
+
+        double microsecondsPerSpectrum = std::chrono::duration<double, std::micro>(stop - start).count() / double(numSpectra);
+        double samplesPerSecond        = 1e6 * double(calibrated.size()) / microsecondsPerSpectrum;
+
+        // the checksum is printed so the calibration cannot be optimized away
+        std::printf(
+            "%-28s %14.1f %18.1f %12.3g %14g\n",
+            description.c_str(),
+            microsecondsPerSpectrum,
+            1e-6 * samplesPerSecond,
+            maxError,
+            checksum
+        );
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // command line options
+    cmnCommandLineOptions options;
+    int numChannels = 16;
+    int numPoints   = 20000;
+    int numSpectra  = 1000;
+
+    options.AddOptionOneValue(
+        "c", "num-channels",
+        "Channels per spectrum (default 16)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &numChannels
+    );
+
+    options.AddOptionOneValue(
+        "p", "num-points",
+        "Points per channel (default 20000)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &numPoints
+    );
+
+    options.AddOptionOneValue(
+        "n", "num-spectra",
+        "Spectra calibrated per configuration (default 1000)",
+        cmnCommandLineOptions::OPTIONAL_OPTION,
+        &numSpectra
+    );
+
+    if (!options.Parse(argc, argv, std::cerr))
+        return -1;
+
+    // raw samples and calibrations in the instrument's ranges
+    Spectrum spectrum;
+    spectrum.NumChannels = size_t(std::max(numChannels, 1));
+    spectrum.NumPoints   = size_t(std::max(numPoints, 1));
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> rawSample(0, 65535);
+    spectrum.Raw.resize(spectrum.NumChannels * spectrum.NumPoints);
+    for (uint16_t& raw : spectrum.Raw)
+        raw = uint16_t(rawSample(generator));
+
+    for (size_t channel = 0; channel < spectrum.NumChannels; channel++)
+    {
+        spectrum.InvScales.push_back(1.0 / double(1000 + 10 * channel));
+        spectrum.Offsets.push_back(-80.0 + double(channel));
+    }
+
+    std::vector<double> reference(spectrum.Raw.size());
+    for (size_t channel = 0; channel < spectrum.NumChannels; channel++)
+        CalibrateScalar<double>(
+            spectrum.Raw.data() + channel * spectrum.NumPoints,
+            spectrum.NumPoints,
+            spectrum.InvScales[channel],
+            spectrum.Offsets[channel],
+            reference.data() + channel * spectrum.NumPoints
+        );
+
+    size_t spectra = size_t(std::max(numSpectra, 1));
+
+    std::printf("%zu channels x %zu points, calibrate_spectrum compiled for %s\n\n", spectrum.NumChannels, spectrum.NumPoints, SIMD_PATH);
+    std::printf("%-28s %14s %18s %12s %14s\n", "Calibration", "Per spectrum", "Throughput",    "Max error", "Checksum");
+    std::printf("%-28s %14s %18s %12s %14s\n", "",            "[us]",         "[M samples/s]", "[dBm]",     "");
+
+    TimeCalibration<double>("plain loop double",         spectrum, reference, spectra, CalibrateScalar<double>);
+    TimeCalibration<double>("calibrate_spectrum double", spectrum, reference, spectra, CalibrateLibrary<double>);
+    TimeCalibration<float>("plain loop float",           spectrum, reference, spectra, CalibrateScalar<float>);
+    TimeCalibration<float>("calibrate_spectrum float",   spectrum, reference, spectra, CalibrateLibrary<float>);
+
+    return 0;
+}
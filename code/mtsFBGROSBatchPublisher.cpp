@@ -0,0 +1,157 @@
+#include "mtsFBGSensor/ROS/mtsFBGROSBatchPublisher.h"
+
+#include <algorithm>
+#include <cmath>
+
+CMN_IMPLEMENT_SERVICES(mtsFBGROSBatchPublisher);
+
+mtsFBGROSBatchPublisher::mtsFBGROSBatchPublisher(const std::string& componentName, const double period, const double sampleRate, ros::NodeHandle* node) :
+    mtsTaskPeriodic(componentName, period),
+    m_Node(node),
+    m_SampleRate(sampleRate)
+{
+
+}
+
+mtsFBGROSBatchPublisher::MailBox* mtsFBGROSBatchPublisher::GetBatchMailBox(const std::string& interfaceName, const size_t maxSamplesPerPeriod)
+{
+    MailBox& box = m_MailBoxes[interfaceName];
+    if (!box.Interface)
+        box.Interface = this->AddInterfaceRequired(interfaceName, MTS_OPTIONAL);
+
+    if (!box.Interface)
+    {
+        CMN_LOG_CLASS_INIT_ERROR << "Error adding \"" << interfaceName << "\" required interface \""
+                                 << this->GetName()
+                                 << "\"!" << std::endl;
+        m_MailBoxes.erase(interfaceName);
+        return nullptr;
+    }
+
+    // every sample of a period waits in the mailbox until the next run (with margin for a late run)
+    box.Size += std::max<size_t>(2 * maxSamplesPerPeriod, 64);
+    box.Interface->SetMailBoxAndArgumentQueuesSize(box.Size);
+
+    return &box;
+}
+
+void mtsFBGROSBatchPublisher::AddVectorBatch(
+    const std::string& interfaceName,
+    const std::string& eventName,
+    const std::string& topic,
+    const size_t       maxSamplesPerPeriod
+)
+{
+    size_t   numSamples = maxSamplesPerPeriod > 0 ? maxSamplesPerPeriod : size_t(std::ceil(m_SampleRate * this->GetPeriodicity()));
+    MailBox* box        = GetBatchMailBox(interfaceName, numSamples);
+    if (!box)
+        return;
+
+    m_VectorBatches.emplace_back(new VectorBatch());
+    VectorBatch* batch = m_VectorBatches.back().get();
+
+    batch->Publisher = m_Node->advertise<mts_fbg_sensor::FBGSampleBatch>(topic, 10);
+    batch->Message.samples.reserve(numSamples);
+    batch->Box       = box;
+
+    box->Interface->AddEventHandlerWrite(&VectorBatch::Append, batch, eventName);
+}
+
+void mtsFBGROSBatchPublisher::AddWrenchBatch(
+    const std::string& interfaceName,
+    const std::string& eventName,
+    const std::string& topic,
+    const std::string& frameId,
+    const size_t       maxSamplesPerPeriod
+)
+{
+    size_t   numSamples = maxSamplesPerPeriod > 0 ? maxSamplesPerPeriod : size_t(std::ceil(m_SampleRate * this->GetPeriodicity()));
+    MailBox* box        = GetBatchMailBox(interfaceName, numSamples);
+    if (!box)
+        return;
+
+    m_WrenchBatches.emplace_back(new WrenchBatch());
+    WrenchBatch* batch = m_WrenchBatches.back().get();
+
+    batch->Publisher = m_Node->advertise<mts_fbg_sensor::WrenchStampedBatch>(topic, 10);
+    batch->FrameId   = frameId;
+    batch->Message.samples.reserve(numSamples);
+    batch->Box       = box;
+
+    box->Interface->AddEventHandlerWrite(&WrenchBatch::Append, batch, eventName);
+}
+
+void mtsFBGROSBatchPublisher::VectorBatch::Append(const mtsDoubleVec& sample)
+{
+    Box->NumSamples++;
+
+    Message.samples.emplace_back();
+    mts_fbg_sensor::FBGSample& sampleMsg = Message.samples.back();
+
+    sampleMsg.stamp.fromSec(sample.Timestamp());
+    sampleMsg.data.assign(sample.begin(), sample.end());
+}
+
+void mtsFBGROSBatchPublisher::WrenchBatch::Append(const mtsDoubleVec& sample)
+{
+    Box->NumSamples++;
+
+    if (sample.size() < 6)
+        return;
+
+    Message.samples.emplace_back();
+    geometry_msgs::WrenchStamped& sampleMsg = Message.samples.back();
+
+    sampleMsg.header.stamp.fromSec(sample.Timestamp());
+    sampleMsg.header.frame_id = FrameId;
+
+    sampleMsg.wrench.force.x  = sample[0];
+    sampleMsg.wrench.force.y  = sample[1];
+    sampleMsg.wrench.force.z  = sample[2];
+    sampleMsg.wrench.torque.x = sample[3];
+    sampleMsg.wrench.torque.y = sample[4];
+    sampleMsg.wrench.torque.z = sample[5];
+}
+
+void mtsFBGROSBatchPublisher::Run()
+{
+    // the event handlers append this period's samples to the messages
+    this->ProcessQueuedEvents();
+
+    // a full mailbox means cisst may have dropped the events that came after
+    for (auto& entry : m_MailBoxes)
+    {
+        MailBox& box = entry.second;
+        if (box.NumSamples >= box.Size)
+        {
+            m_NumberOfOverflows++;
+            CMN_LOG_CLASS_RUN_WARNING << "Run " << this->GetName() << ": \"" << entry.first << "\" mailbox full ("
+                                      << box.NumSamples << " samples in one period), samples may have been dropped ("
+                                      << m_NumberOfOverflows << " overflows so far)" << std::endl;
+        }
+        box.NumSamples = 0;
+    }
+
+    ros::Time now = ros::Time::now();
+
+    for (auto& batch : m_VectorBatches)
+    {
+        if (batch->Message.samples.empty())
+            continue;
+
+        batch->Message.header.stamp = now;
+        batch->Publisher.publish(batch->Message);
+        batch->Message.samples.clear();
+    }
+
+    for (auto& batch : m_WrenchBatches)
+    {
+        if (batch->Message.samples.empty())
+            continue;
+
+        batch->Message.header.stamp    = now;
+        batch->Message.header.frame_id = batch->FrameId;
+        batch->Publisher.publish(batch->Message);
+        batch->Message.samples.clear();
+    }
+}
@@ -1,5 +1,10 @@
 #include "mtsFBGSensor/mtsFBGSensor/mtsFBGSensor.h"
 
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
 CMN_IMPLEMENT_SERVICES_DERIVED(mtsFBGSensor, mtsTaskContinuous);
 
 mtsFBGSensor::mtsFBGSensor(const std::string& componentName) : mtsTaskContinuous(componentName), m_StateTable(50, "FBGSensorState")
@@ -23,11 +28,11 @@ void mtsFBGSensor::Configure(const std::string & fileName)
 {
     std::string      ipAddress;
     InterrogatorType interrogatorType;
+    Json::Value      jsonConfig;
 
     try
     {
         std::ifstream jsonStream;
-        Json::Value   jsonConfig;
         Json::Reader  jsonReader;
 
         jsonStream.open(fileName.c_str());
@@ -46,48 +51,114 @@ void mtsFBGSensor::Configure(const std::string & fileName)
                                    << jsonConfig << std::endl
                                    << "<----" << std::endl;
 
-        if (!jsonConfig.isMember("IP_Address"))
+        if (!jsonConfig.isMember("Interrogator_Type"))
         {
             CMN_LOG_CLASS_INIT_ERROR << "Configure " << this->GetName()
                                      << ": make sure the configuration file \""
-                                     << fileName << "\" has the \"IP_Address\" field"
+                                     << fileName << "\" has the \"Interrogator_Type\" field"
                                      << std::endl;
             return;
         }
-        ipAddress = jsonConfig["IP_Address"].asString();
+        std::string type = jsonConfig["Interrogator_Type"].asString();
 
-        if (!jsonConfig.isMember("Interrogator_Type"))
+        if (!InterrogatorFactory::ParseInterrogatorType(type, interrogatorType))
+        {
+            CMN_LOG_CLASS_INIT_ERROR << "Configure " << this->GetName()
+                                     << ": the configuration file \""
+                                     << fileName << "\" has an invalid \"Interrogator_Type\" field: \""
+                                     << type << "\""
+                                     << std::endl;
+            return;
+        }
+
+        // an aggregating interrogator takes the addresses of its "Interrogators"
+        if (!jsonConfig.isMember("IP_Address") && interrogatorType != InterrogatorType::MULTI)
         {
             CMN_LOG_CLASS_INIT_ERROR << "Configure " << this->GetName()
                                      << ": make sure the configuration file \""
-                                     << fileName << "\" has the \"Interrogator_Type\" field"
+                                     << fileName << "\" has the \"IP_Address\" field"
                                      << std::endl;
             return;
         }
-        std::string type = jsonConfig["Interrogator_Type"].asString();
-        std::transform(
-            type.begin(),
-            type.end(),
-            type.begin(),
-            [] (unsigned char c) {return std::toupper(c);}
-        );
+        ipAddress = jsonConfig.get("IP_Address", "").asString();
 
-        if (type == "HYPERION")
-            interrogatorType = InterrogatorType::HYPERION;
+        if (jsonConfig.isMember("Streaming") && jsonConfig["Streaming"].isMember("Enabled"))
+            m_StreamPeaks = jsonConfig["Streaming"]["Enabled"].asBool();
 
-        else if (type == "SI155")
-            interrogatorType = InterrogatorType::SI155;
+        if (jsonConfig.isMember("FBG_Slots"))
+        {
+            try
+            {
+                m_SlotMap.Configure(jsonConfig["FBG_Slots"]);
+            }
+            catch(const std::invalid_argument& e)
+            {
+                CMN_LOG_CLASS_INIT_ERROR << "Configure " << this->GetName()
+                                         << ": invalid \"FBG_Slots\" in \"" << fileName << "\": "
+                                         << e.what() << std::endl;
+            }
+
+            // the peaks keep this size from the first sample on
+            m_Peaks.SetSize(m_SlotMap.GetNumberOfSlots());
+            m_Peaks.SetAll(std::numeric_limits<double>::quiet_NaN());
+            m_PeaksValid.SetSize(m_SlotMap.GetNumberOfSlots());
+            m_PeaksValid.SetAll(false);
+        }
 
-        else if (type == "SM130")
-            interrogatorType = InterrogatorType::SM130;
+        if (jsonConfig.isMember("Peak_Quality"))
+        {
+            const Json::Value jsonQuality = jsonConfig["Peak_Quality"];
 
-        else
+            if (jsonQuality.isMember("Min_SNR"))
+                m_PeakQualityLimits.MinSNR = jsonQuality["Min_SNR"].asDouble();
+
+            if (jsonQuality.isMember("Max_FWHM"))
+                m_PeakQualityLimits.MaxFWHM = jsonQuality["Max_FWHM"].asDouble();
+
+            if (jsonQuality.isMember("Max_Asymmetry"))
+                m_PeakQualityLimits.MaxAsymmetry = jsonQuality["Max_Asymmetry"].asDouble();
+        }
+
+        if (jsonConfig.isMember("Real_Time"))
+            m_RealTimeSettings.Configure(jsonConfig["Real_Time"]);
+
+        if (jsonConfig.isMember("Sweep_Monitor"))
         {
-            CMN_LOG_CLASS_INIT_ERROR << "Configure " << this->GetName()
-                                     << ": the configuration file \""
-                                     << fileName << "\" has an invalid \"Interrogator_Type\" field: \""
-                                     << type << "\""
-                                     << std::endl;
+            const Json::Value jsonMonitor = jsonConfig["Sweep_Monitor"];
+
+            if (jsonMonitor.isMember("Drop_Threshold"))
+                m_SweepMonitor.DropThreshold = jsonMonitor["Drop_Threshold"].asUInt();
+
+            if (jsonMonitor.isMember("Gap_Threshold"))
+                m_SweepMonitor.GapThreshold = jsonMonitor["Gap_Threshold"].asDouble();
+        }
+
+        if (jsonConfig.isMember("Clock_Synchronization"))
+            m_ClockSynchronizer.Configure(jsonConfig["Clock_Synchronization"]);
+
+        if (jsonConfig.isMember("Rate_Adaptation"))
+        {
+            const Json::Value jsonAdaptation = jsonConfig["Rate_Adaptation"];
+
+            m_RateAdaptation.Enabled = jsonAdaptation.get("Enabled", true).asBool();
+
+            if (jsonAdaptation.isMember("Queue_High"))
+                m_RateAdaptation.QueueHigh = jsonAdaptation["Queue_High"].asUInt();
+
+            if (jsonAdaptation.isMember("Queue_Low"))
+                m_RateAdaptation.QueueLow = jsonAdaptation["Queue_Low"].asUInt();
+
+            if (jsonAdaptation.isMember("Max_Processing_Fraction"))
+                m_RateAdaptation.MaxProcessingFraction = jsonAdaptation["Max_Processing_Fraction"].asDouble();
+
+            if (jsonAdaptation.isMember("Hold_Cycles"))
+                m_RateAdaptation.HoldCycles = jsonAdaptation["Hold_Cycles"].asUInt();
+
+            if (jsonAdaptation.isMember("Restore_Cycles"))
+                m_RateAdaptation.RestoreCycles = jsonAdaptation["Restore_Cycles"].asUInt();
+
+            if (jsonAdaptation.isMember("Max_Divider"))
+                m_RateAdaptation.MaxDivider = jsonAdaptation["Max_Divider"].asInt();
         }
 
     }
@@ -109,18 +180,51 @@ void mtsFBGSensor::Configure(const std::string & fileName)
     if (!m_Interrogator)
     {
         CMN_LOG_CLASS_INIT_ERROR << "Error creating interrogator @ " << ipAddress << std::endl;
+        return;
     }
 
-    m_Interrogator->StreamPeaks(); // FIXME: change to config from json file
+    // the interrogators' parsers throw on values of the wrong JSON type
+    try
+    {
+        m_Interrogator->Configure(jsonConfig);
+    }
+    catch(const std::exception& e)
+    {
+        CMN_LOG_CLASS_INIT_ERROR << "Configure " << this->GetName()
+                                 << ": invalid interrogator settings in \"" << fileName << "\": "
+                                 << e.what() << std::endl;
+    }
 
 }
 
 void mtsFBGSensor::Startup()
 {
+    // Startup runs on the task's thread
+    if (m_RealTimeSettings.IsConfigured())
+    {
+        if (m_RealTimeSettings.Apply(this->GetName(), m_RealTimeReport.Data))
+            CMN_LOG_CLASS_INIT_VERBOSE << "Startup: " << m_RealTimeReport.Data << std::endl;
+        else
+            CMN_LOG_CLASS_INIT_WARNING << "Startup: " << m_RealTimeReport.Data << std::endl;
+    }
+
     if (!m_Interrogator->Connect())
     {
         CMN_LOG_CLASS_INIT_ERROR << "Error connecting to interrogator!" << std::endl;
+        return;
     }
+
+    if (m_StreamPeaks)
+    {
+        m_Interrogator->StreamPeaks();
+        CMN_LOG_CLASS_INIT_VERBOSE << "Startup: streaming peaks at "
+                                   << m_Interrogator->GetStreamingRate() << " Hz" << std::endl;
+    }
+    m_StreamingRate = m_Interrogator->GetStreamingRate();
+
+    m_RateAdaptation.BaseDivider = m_Interrogator->GetStreamingDivider();
+
+    m_ClockSynchronizer.Reset();
 }
 
 void mtsFBGSensor::Run()
@@ -132,8 +236,259 @@ void mtsFBGSensor::Run()
         return;
 
     // get the current interrogator peaks
-    m_Peaks = m_Interrogator->GetPeaks();
+    std::chrono::steady_clock::time_point frameReceivedTime;
+    if (m_SlotMap.IsConfigured())
+    {
+        std::vector<vctDoubleVec> channelPeaks = m_Interrogator->GetChannelPeaks();
+        frameReceivedTime = std::chrono::steady_clock::now();
+
+        m_SlotMap.Assign(channelPeaks, m_Peaks, m_PeaksValid);
+        m_NumberOfUnassignedPeaks = m_SlotMap.GetNumberOfUnassignedPeaks();
+    }
+    else
+    {
+        m_Peaks = m_Interrogator->GetPeaks();
+        frameReceivedTime = std::chrono::steady_clock::now();
+
+        m_PeaksValid.SetSize(m_Peaks.size());
+        m_PeaksValid.SetAll(true);
+    }
+    UpdatePeaksTimestamp();
+    bool isNewFrame = UpdateSweepCounters();
+    UpdatePeakQuality();
+
+    // every frame goes out with its acquisition time, however often the state is read
+    if (isNewFrame)
+    {
+        if (!m_PeaksSubscribers.IsEmpty())
+        {
+            m_PeaksFrame.Time         = m_PeaksTimestamp.Data;
+            m_PeaksFrame.SerialNumber = m_Interrogator->GetPeaksSerialNumber();
+            m_PeaksFrame.Peaks        = m_Peaks;
+            m_PeaksFrame.PeaksValid   = m_PeaksValid;
+            m_PeaksSubscribers.Notify(m_PeaksFrame);
+        }
+
+        m_Peaks.SetTimestamp(m_PeaksTimestamp.Data);
+        m_PeaksSampleEvent(m_Peaks);
+    }
+
+    // from receiving the frame to handing it off, in-process subscribers included
+    m_FrameProcessingTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - frameReceivedTime).count();
+
+    // a polled sensor has no divider to adapt
+    m_NumberOfQueuedFrames = m_Interrogator->GetNumberOfQueuedFrames();
+    if (m_RateAdaptation.Enabled && m_StreamPeaks)
+        AdaptStreamingRate();
+
+    m_StreamingBufferAvailable = m_Interrogator->GetStreamingBufferAvailable();
+    m_NumberOfCollapsedFrames  = m_Interrogator->GetNumberOfCollapsedFrames();
+
+}
+
+void mtsFBGSensor::UpdatePeaksTimestamp()
+{
+    // system clock, like the stamps of the kinematics the forces are fused with
+    double hostTime       = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    double instrumentTime = m_Interrogator->GetPeaksTimestamp();
+
+    if (!m_ClockSynchronizer.IsEnabled() || std::isnan(instrumentTime))
+    {
+        m_PeaksTimestamp = hostTime;
+        return;
+    }
+
+    m_ClockSynchronizer.AddSample(instrumentTime, hostTime);
+
+    m_PeaksTimestamp = m_ClockSynchronizer.ToHostTime(instrumentTime);
+    m_ClockOffset    = m_ClockSynchronizer.GetOffset();
+    m_ClockSkew      = m_ClockSynchronizer.GetSkew();
+    m_NetworkDelay   = m_ClockSynchronizer.GetNetworkDelay();
+}
+
+bool mtsFBGSensor::UpdateSweepCounters()
+{
+    int64_t serialNumber = m_Interrogator->GetPeaksSerialNumber();
+    double  time         = m_PeaksTimestamp.Data;
+    int     divider      = m_Interrogator->GetStreamingDivider();
+
+    if (divider != m_SweepMonitor.Divider)
+    {
+        m_SweepMonitor.Divider    = divider;
+        m_SweepMonitor.SerialStep = 0;
+    }
+
+    if (serialNumber >= 0 && m_SweepMonitor.LastSerialNumber >= 0)
+    {
+        int64_t delta = serialNumber - m_SweepMonitor.LastSerialNumber;
+
+        // the same frame again: neither a new sample nor a gap
+        if (delta == 0)
+        {
+            m_NumberOfDuplicatedSweeps = m_NumberOfDuplicatedSweeps.Data + 1;
+            return false;
+        }
+
+        // the instrument numbers either every sweep (step of the divider) or every streamed
+        // sample (step of 1); the smallest increment seen tells which. Polled frames skip sweeps
+        // by design, and drained frames were received, so neither counts as dropped.
+        if (delta > 0 && m_Interrogator->GetIsStreaming())
+        {
+            m_SweepMonitor.SerialStep = m_SweepMonitor.SerialStep == 0 ?
+                std::min<int64_t>(delta, divider) :
+                std::min<int64_t>(delta, m_SweepMonitor.SerialStep);
+
+            int64_t numDropped = delta / m_SweepMonitor.SerialStep - int64_t(m_Interrogator->GetNumberOfCollapsedFrames());
+            if (numDropped > 0)
+            {
+                m_NumberOfDroppedSweeps = m_NumberOfDroppedSweeps.Data + unsigned(numDropped);
+                m_SweepMonitor.NumDroppedSinceEvent += numDropped;
+            }
+        }
+
+        // a serial number going back is a restarted instrument
+        else if (delta < 0)
+            m_SweepMonitor.SerialStep = 0;
+    }
+    m_SweepMonitor.LastSerialNumber = serialNumber;
+
+    if (m_SweepMonitor.DropThreshold > 0 && m_SweepMonitor.NumDroppedSinceEvent >= m_SweepMonitor.DropThreshold)
+    {
+        mtsUInt numDropped = unsigned(m_SweepMonitor.NumDroppedSinceEvent);
+        m_SweepsDroppedEvent(numDropped);
+        m_SweepMonitor.NumDroppedSinceEvent = 0;
+
+        CMN_LOG_CLASS_RUN_WARNING << "Run " << this->GetName() << ": " << numDropped.Data << " sweeps dropped ("
+                                  << m_NumberOfDroppedSweeps.Data << " in total)" << std::endl;
+    }
+
+    double gap = time - m_SweepMonitor.LastTime;
+    m_SweepMonitor.LastTime = time;
+    if (std::isnan(gap))
+        return true;
+
+    if (gap > m_LongestGap.Data)
+        m_LongestGap = gap;
+
+    if (m_SweepMonitor.GapThreshold > 0 && gap > m_SweepMonitor.GapThreshold)
+    {
+        m_SweepGapEvent(mtsDouble(gap));
+
+        CMN_LOG_CLASS_RUN_WARNING << "Run " << this->GetName() << ": no frame for "
+                                  << gap * 1e3 << " ms" << std::endl;
+    }
+
+    return true;
+}
+
+void mtsFBGSensor::ResetSweepCounters()
+{
+    m_NumberOfDroppedSweeps    = 0;
+    m_NumberOfDuplicatedSweeps = 0;
+    m_LongestGap               = 0.0;
+
+    m_SweepMonitor.NumDroppedSinceEvent = 0;
+}
+
+void mtsFBGSensor::UpdatePeakQuality()
+{
+    std::vector<vctDoubleMat> channelQuality = m_Interrogator->GetChannelPeakQuality();
+
+    m_PeakQuality.SetSize(m_Peaks.size(), NUM_PEAK_QUALITY_METRICS);
+    m_PeakQuality.SetAll(std::numeric_limits<double>::quiet_NaN());
+
+    // rows follow m_Peaks: FBG slots, or the channels' peaks concatenated
+    if (m_SlotMap.IsConfigured())
+    {
+        for (size_t slot = 0; slot < m_PeakQuality.rows(); slot++)
+        {
+            if (!m_PeaksValid[slot])
+                continue;
+
+            const FBGSlotMap::PeakSource& source = m_SlotMap.GetSlotSource(slot);
+            if (source.Channel >= channelQuality.size() || source.Index >= channelQuality[source.Channel].rows())
+                continue;
 
+            for (size_t metric = 0; metric < NUM_PEAK_QUALITY_METRICS; metric++)
+                m_PeakQuality.Element(slot, metric) = channelQuality[source.Channel].Element(source.Index, metric);
+        }
+    }
+    else
+    {
+        size_t row = 0;
+        for (size_t ch = 0; ch < channelQuality.size(); ch++)
+            for (size_t idx = 0; idx < channelQuality[ch].rows() && row < m_PeakQuality.rows(); idx++, row++)
+                for (size_t metric = 0; metric < NUM_PEAK_QUALITY_METRICS; metric++)
+                    m_PeakQuality.Element(row, metric) = channelQuality[ch].Element(idx, metric);
+    }
+
+    // flag degraded gratings (comparisons with NaN limits or metrics never fail)
+    for (size_t i = 0; i < m_PeakQuality.rows() && i < m_PeaksValid.size(); i++)
+    {
+        if (
+            m_PeakQuality.Element(i, PEAK_SNR) < m_PeakQualityLimits.MinSNR
+            || m_PeakQuality.Element(i, PEAK_FWHM) > m_PeakQualityLimits.MaxFWHM
+            || std::abs(m_PeakQuality.Element(i, PEAK_ASYMMETRY)) > m_PeakQualityLimits.MaxAsymmetry
+        )
+            m_PeaksValid[i] = false;
+    }
+}
+
+void mtsFBGSensor::GetFBGSlotNames(mtsStdStringVec& names) const
+{
+    names.Data.clear();
+    for (const FBGSlot& slot : m_SlotMap.GetSlots())
+        names.Data.push_back(slot.Name);
+}
+
+void mtsFBGSensor::AdaptStreamingRate()
+{
+    int    divider     = m_Interrogator->GetStreamingDivider();
+    double framePeriod = m_StreamingRate.Data > 0 ? 1.0 / m_StreamingRate.Data : 0.0;
+
+    // without a known rate there is no processing budget, only the queue
+    double processingBudget = m_RateAdaptation.MaxProcessingFraction * framePeriod;
+    bool   hasBudget        = framePeriod > 0.0;
+
+    bool overloaded = (
+        m_NumberOfQueuedFrames.Data > m_RateAdaptation.QueueHigh
+        || (hasBudget && m_FrameProcessingTime.Data > processingBudget)
+    );
+
+    // restoring doubles the rate, so require the load to fit in half of the current budget
+    bool underloaded = (
+        m_NumberOfQueuedFrames.Data <= m_RateAdaptation.QueueLow
+        && (!hasBudget || m_FrameProcessingTime.Data < 0.5 * processingBudget)
+    );
+
+    m_RateAdaptation.OverloadCount  = overloaded  ? m_RateAdaptation.OverloadCount + 1  : 0;
+    m_RateAdaptation.UnderloadCount = underloaded ? m_RateAdaptation.UnderloadCount + 1 : 0;
+
+    int newDivider = divider;
+    if (m_RateAdaptation.OverloadCount >= m_RateAdaptation.HoldCycles && divider < m_RateAdaptation.MaxDivider)
+        newDivider = std::min(2 * divider, m_RateAdaptation.MaxDivider);
+
+    else if (m_RateAdaptation.UnderloadCount >= m_RateAdaptation.RestoreCycles && divider > m_RateAdaptation.BaseDivider)
+        newDivider = std::max(divider / 2, m_RateAdaptation.BaseDivider);
+
+    if (newDivider == divider)
+        return;
+
+    m_RateAdaptation.OverloadCount  = 0;
+    m_RateAdaptation.UnderloadCount = 0;
+
+    if (!m_Interrogator->SetStreamingDivider(newDivider))
+        return;
+
+    m_StreamingRate = m_Interrogator->GetStreamingRate();
+    m_StreamingRateChangedEvent(m_StreamingRate);
+
+    CMN_LOG_CLASS_RUN_WARNING << "Run " << this->GetName()
+                              << ": streaming divider changed from " << divider << " to " << newDivider
+                              << " (" << m_StreamingRate.Data << " Hz, "
+                              << m_NumberOfQueuedFrames.Data << " queued frames, "
+                              << m_FrameProcessingTime.Data * 1e6 << " us per frame)"
+                              << std::endl;
 }
 
 void mtsFBGSensor::Cleanup()
@@ -147,7 +502,24 @@ void mtsFBGSensor::Cleanup()
 
 void mtsFBGSensor::SetupInterfaces()
 {
+    AddStateTable(&m_StateTable);
+
     m_StateTable.AddData(m_Peaks, "Peaks");
+    m_StateTable.AddData(m_PeaksValid,               "PeaksValid");
+    m_StateTable.AddData(m_NumberOfUnassignedPeaks,  "NumberOfUnassignedPeaks");
+    m_StateTable.AddData(m_PeakQuality,              "PeakQuality");
+    m_StateTable.AddData(m_PeaksTimestamp,           "PeaksTimestamp");
+    m_StateTable.AddData(m_ClockOffset,              "ClockOffset");
+    m_StateTable.AddData(m_ClockSkew,                "ClockSkew");
+    m_StateTable.AddData(m_NetworkDelay,             "NetworkDelay");
+    m_StateTable.AddData(m_StreamingRate,            "StreamingRate");
+    m_StateTable.AddData(m_StreamingBufferAvailable, "StreamingBufferAvailable");
+    m_StateTable.AddData(m_NumberOfCollapsedFrames,  "NumberOfCollapsedFrames");
+    m_StateTable.AddData(m_NumberOfQueuedFrames,     "NumberOfQueuedFrames");
+    m_StateTable.AddData(m_FrameProcessingTime,      "FrameProcessingTime");
+    m_StateTable.AddData(m_NumberOfDroppedSweeps,    "NumberOfDroppedSweeps");
+    m_StateTable.AddData(m_NumberOfDuplicatedSweeps, "NumberOfDuplicatedSweeps");
+    m_StateTable.AddData(m_LongestGap,               "LongestGap");
 
     // Add the interface
     mtsInterfaceProvided* intfProvided = this->AddInterfaceProvided("ProvidesFBGSensor");
@@ -166,12 +538,40 @@ void mtsFBGSensor::SetupInterfaces()
                                  << "\"!" << std::endl;
     }
 
+    intfProvided->AddCommandReadState(m_StateTable, m_PeaksValid,               "GetFBGPeaksValidState");
+    intfProvided->AddCommandReadState(m_StateTable, m_NumberOfUnassignedPeaks,  "GetNumberOfUnassignedPeaks");
+    intfProvided->AddCommandReadState(m_StateTable, m_PeakQuality,              "GetFBGPeakQuality");
+    intfProvided->AddCommandReadState(m_StateTable, m_PeaksTimestamp,           "GetFBGPeaksTimestamp");
+    intfProvided->AddCommandRead(&mtsFBGSensor::GetFBGSlotNames, this, "GetFBGSlotNames");
+
+    intfProvided->AddCommandReadState(m_StateTable, m_ClockOffset,              "GetClockOffset");
+    intfProvided->AddCommandReadState(m_StateTable, m_ClockSkew,                "GetClockSkew");
+    intfProvided->AddCommandReadState(m_StateTable, m_NetworkDelay,             "GetNetworkDelay");
+
+    intfProvided->AddCommandReadState(m_StateTable, m_StreamingRate,            "GetStreamingRate");
+    intfProvided->AddCommandReadState(m_StateTable, m_StreamingBufferAvailable, "GetStreamingBufferAvailable");
+    intfProvided->AddCommandReadState(m_StateTable, m_NumberOfCollapsedFrames,  "GetNumberOfCollapsedFrames");
+    intfProvided->AddCommandReadState(m_StateTable, m_NumberOfQueuedFrames,     "GetNumberOfQueuedFrames");
+    intfProvided->AddCommandReadState(m_StateTable, m_FrameProcessingTime,      "GetFrameProcessingTime");
+
+    intfProvided->AddEventWrite(m_StreamingRateChangedEvent, "StreamingRateChanged", mtsDouble());
+
+    intfProvided->AddCommandReadState(m_StateTable, m_NumberOfDroppedSweeps,    "GetNumberOfDroppedSweeps");
+    intfProvided->AddCommandReadState(m_StateTable, m_NumberOfDuplicatedSweeps, "GetNumberOfDuplicatedSweeps");
+    intfProvided->AddCommandReadState(m_StateTable, m_LongestGap,               "GetLongestGap");
+    intfProvided->AddCommandVoid(&mtsFBGSensor::ResetSweepCounters, this, "ResetSweepCounters");
+
+    intfProvided->AddCommandRead(&mtsFBGSensor::GetRealTimeReport, this, "GetRealTimeReport");
+
+    intfProvided->AddEventWrite(m_SweepsDroppedEvent, "SweepsDropped", mtsUInt());
+    intfProvided->AddEventWrite(m_SweepGapEvent,      "SweepGap",      mtsDouble());
+
+    intfProvided->AddEventWrite(m_PeaksSampleEvent, "FBGPeaksSample", mtsDoubleVec());
+
     intfProvided->AddCommandRead(&mtsFBGSensor::GetNumberOfChannels,       this, "GetNumberOfChannels");
     intfProvided->AddCommandQualifiedRead(&mtsFBGSensor::GetNumberOfPeaks, this, "GetNumberOfPeaks");
 
     intfProvided->AddCommandVoidReturn(&mtsFBGSensor::Connect,    this, "Connect");
     intfProvided->AddCommandVoidReturn(&mtsFBGSensor::Disconnect, this, "Disonnect");
 
-    delete intfProvided;
-
 }
@@ -1,5 +1,8 @@
 #include "mtsFBGSensor/mtsFBGTool/mtsFBGTool.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <cisstOSAbstraction/osaSleep.h>
 
 #include "mtsFBGSensor/mtsFBGTool/FBGToolFactory.h"
@@ -14,6 +17,9 @@ mtsFBGTool::mtsFBGTool(const std::string& taskName) :
 {
     m_ForcesTipCF.Zeros();
     m_ForcesScleraCF.Zeros();
+
+    // the interfaces exist whatever the configuration, so connections do not depend on it
+    SetupInterfaces();
 }
 
 mtsFBGTool::~mtsFBGTool()
@@ -90,7 +96,35 @@ void mtsFBGTool::Configure(const std::string& filename)
 
         if (jsonConfig.isMember("FBGSensor_Num_Samples"))
             numSamples = jsonConfig["FBGSensor_Num_Samples"].asInt();
-        
+
+        if (jsonConfig.isMember("Real_Time"))
+            m_RealTimeSettings.Configure(jsonConfig["Real_Time"]);
+
+        if (jsonConfig.isMember("Resampling"))
+            m_Resampler.Configure(jsonConfig["Resampling"]);
+
+        if (jsonConfig.isMember("Outlier_Filter"))
+            m_OutlierFilter.Configure(jsonConfig["Outlier_Filter"]);
+
+        if (jsonConfig.isMember("Wavelength_Filters"))
+            m_WavelengthFilters.Configure(jsonConfig["Wavelength_Filters"]);
+
+        if (jsonConfig.isMember("Estimator"))
+            m_Estimator.Configure(jsonConfig["Estimator"]);
+
+        if (jsonConfig.isMember("Temperature_Compensation"))
+            m_TemperatureCompensation.Configure(jsonConfig["Temperature_Compensation"]);
+
+        if (jsonConfig.isMember("Tare"))
+        {
+            const Json::Value& jsonTare = jsonConfig["Tare"];
+            m_TareNumSamples = std::max(jsonTare.get("Num_Samples", 1000).asUInt(), 2u);
+            m_TareOnStartup  = jsonTare.get("On_Startup", false).asBool();
+        }
+
+        if (jsonConfig.isMember("Force_Filters"))
+            m_ForceFilters.Configure(jsonConfig["Force_Filters"]);
+
 
     }
     catch(...)
@@ -103,6 +137,9 @@ void mtsFBGTool::Configure(const std::string& filename)
 
     m_FBGTool = FBGToolFactory::GetFBGTool(device, deviceConfigFile);
 
+    if (m_FBGTool)
+        m_BaseWavelengths = m_FBGTool->GetBaseWavelengths();
+
     // Setup peak container
     if (numPeaks > 0)
         m_WavelengthPeakContainer.Configure(numPeaks, numSamples);
@@ -110,6 +147,9 @@ void mtsFBGTool::Configure(const std::string& filename)
 
 void mtsFBGTool::SetupInterfaces()
 {
+    // the task advances its registered state tables every run
+    AddStateTable(&m_StateTable);
+
     // add states to state table
     m_StateTable.AddData(m_Forces,           "MeasuredCartesianForces");
 
@@ -122,6 +162,15 @@ void mtsFBGTool::SetupInterfaces()
     m_StateTable.AddData(m_ForcesNorm,        "MeasuredCartesianForceNorm");
     m_StateTable.AddData(m_ForcesDirection,   "MeasuredCartesianForceDirection");
 
+    m_StateTable.AddData(m_ResamplingGap,      "ResamplingGap");
+    m_StateTable.AddData(m_NumberOfGapSamples, "NumberOfGapSamples");
+    m_StateTable.AddData(m_NumberOfOutliers,   "NumberOfOutliers");
+    m_StateTable.AddData(m_CommonModeShifts,   "CommonModeShifts");
+
+    m_StateTable.AddData(m_BaseWavelengths, "BaseWavelengths");
+    m_StateTable.AddData(m_NoiseFloor,      "NoiseFloor");
+    m_StateTable.AddData(m_TareActive,      "TareActive");
+
     // Add provided interface
     mtsInterfaceProvided * providedInterface = this->AddInterfaceProvided("ProvidesFBGTool");
     if (!providedInterface)
@@ -144,13 +193,26 @@ void mtsFBGTool::SetupInterfaces()
     providedInterface->AddCommandReadState(m_StateTable, m_ForcesTipCF,        "GetMeasuredCartesianForcesTip");
     providedInterface->AddCommandReadState(m_StateTable, m_ForcesScleraCF,     "GetMeasuredCartesianForcesSclera");
     
-    providedInterface->AddCommandRead(&FBGToolInterface::GetToolName, m_FBGTool.get(), "GetToolName");
-
-    delete providedInterface;
+    providedInterface->AddCommandReadState(m_StateTable, m_ResamplingGap,      "GetResamplingGap");
+    providedInterface->AddCommandReadState(m_StateTable, m_NumberOfGapSamples, "GetNumberOfGapSamples");
+    providedInterface->AddCommandReadState(m_StateTable, m_NumberOfOutliers,   "GetNumberOfOutliers");
+    providedInterface->AddCommandReadState(m_StateTable, m_CommonModeShifts,   "GetCommonModeShifts");
+
+    providedInterface->AddCommandReadState(m_StateTable, m_BaseWavelengths, "GetBaseWavelengths");
+    providedInterface->AddCommandReadState(m_StateTable, m_NoiseFloor,      "GetNoiseFloor");
+    providedInterface->AddCommandReadState(m_StateTable, m_TareActive,      "GetTareActive");
+    providedInterface->AddCommandVoid(&mtsFBGTool::Tare, this, "Tare");
+    providedInterface->AddEventWrite(m_TareCompletedEvent, "TareCompleted", mtsDoubleVec());
     
+    providedInterface->AddCommandRead(&mtsFBGTool::GetToolName, this, "GetToolName");
+    providedInterface->AddCommandRead(&mtsFBGTool::GetRealTimeReport, this, "GetRealTimeReport");
+
+    providedInterface->AddEventWrite(m_ForcesTipSampleEvent,    "MeasuredCartesianForcesTipSample",    mtsDoubleVec());
+    providedInterface->AddEventWrite(m_ForcesScleraSampleEvent, "MeasuredCartesianForcesScleraSample", mtsDoubleVec());
+
     // Add required interface
     mtsInterfaceRequired* requiredInterface = this->AddInterfaceRequired("RequiresFBGSensor");
-    if (!providedInterface)
+    if (!requiredInterface)
     {
         CMN_LOG_CLASS_INIT_ERROR << "Error adding \"RequiresFBGSensor\" required interface \"" 
                                  << this->GetName()
@@ -159,14 +221,23 @@ void mtsFBGTool::SetupInterfaces()
         return;
     }
 
-    requiredInterface->AddFunction("GetFBGPeaks", m_ReadStateFBGPeaks);
-
-    delete requiredInterface;
+    requiredInterface->AddFunction("GetFBGPeaksState",     m_ReadStateFBGPeaks);
+    requiredInterface->AddFunction("GetFBGPeaksTimestamp", m_ReadStateFBGPeaksTimestamp, MTS_OPTIONAL);
 }
 
 void mtsFBGTool::Startup()
 {
+    if (m_TareOnStartup)
+        Tare();
 
+    // Startup runs on the task's thread
+    if (!m_RealTimeSettings.IsConfigured())
+        return;
+
+    if (m_RealTimeSettings.Apply(this->GetName(), m_RealTimeReport.Data))
+        CMN_LOG_CLASS_INIT_VERBOSE << "Startup: " << m_RealTimeReport.Data << std::endl;
+    else
+        CMN_LOG_CLASS_INIT_WARNING << "Startup: " << m_RealTimeReport.Data << std::endl;
 }
 
 void mtsFBGTool::Cleanup()
@@ -175,42 +246,239 @@ void mtsFBGTool::Cleanup()
 
 }
 
-void mtsFBGTool::Run()
+double mtsFBGTool::UpdatePeakSamples()
 {
-    ProcessQueuedCommands();
-    ProcessQueuedEvents();
-
-    // Get Number of Samples for Peaks 
-    //      (Can be updated to update per run for a single peak, rather than all peaks at once)
     mtsDoubleVec peakSample;
-    for (size_t i = 0; i < m_WavelengthPeakContainer.NumSamples; i++)
+    if (!m_Resampler.IsEnabled())
     {
-        mtsExecutionResult result = m_ReadStateFBGPeaks(peakSample); // may need to check peak state updated
-        if (!result.IsOK())
-            continue;
+        // without the sensor's timestamps every run is treated as a new sample
+        mtsDouble peaksTimestamp;
+        bool      hasTimestamp = m_ReadStateFBGPeaksTimestamp(peaksTimestamp).IsOK();
+        if (hasTimestamp && peaksTimestamp.Data == m_LastPeaksTimestamp)
+            return std::numeric_limits<double>::quiet_NaN();
+
+        double sampleTime = hasTimestamp
+            ? peaksTimestamp.Data
+            : mtsTaskManager::GetInstance()->GetTimeServer().GetAbsoluteTimeInSeconds();
+
+        // Get Number of Samples for Peaks 
+        //      (Can be updated to update per run for a single peak, rather than all peaks at once)
+        //      The outlier filter, the filters and the estimator take every sensor frame once.
+        size_t numReads = UsesEverySample() ? 1 : m_WavelengthPeakContainer.NumSamples;
+        for (size_t i = 0; i < numReads; i++)
+        {
+            mtsExecutionResult result = m_ReadStateFBGPeaks(peakSample); // may need to check peak state updated
+            if (!result.IsOK())
+                continue;
+
+            if (
+                !m_WavelengthPeakContainer.IsConfigured
+                && (m_WavelengthPeakContainer.Peaks.cols() != peakSample.size())
+            )
+            {
+                m_WavelengthPeakContainer.Configure(peakSample.size(), m_WavelengthPeakContainer.NumSamples);
+            }
+
+            AddPeakSample(sampleTime, peakSample);
+        }
+
+        if (hasTimestamp)
+            m_LastPeaksTimestamp = peaksTimestamp.Data;
 
+        return sampleTime;
+    }
+
+    // the timestamp read on either side of the peaks tells if the sensor advanced in between
+    mtsDouble peaksTimestamp, checkTimestamp;
+    if (
+        !m_ReadStateFBGPeaksTimestamp(peaksTimestamp).IsOK()
+        || !m_ReadStateFBGPeaks(peakSample).IsOK()
+        || !m_ReadStateFBGPeaksTimestamp(checkTimestamp).IsOK()
+        || peaksTimestamp.Data != checkTimestamp.Data
+    )
+        return std::numeric_limits<double>::quiet_NaN();
+
+    // the sensor's state is polled faster than it updates
+    if (!m_Resampler.AddSample(peaksTimestamp.Data, peakSample))
+        return std::numeric_limits<double>::quiet_NaN();
+
+    const std::vector<UniformSample>& samples = m_Resampler.GetUniformSamples();
+    for (const UniformSample& sample : samples)
+    {
         if (
             !m_WavelengthPeakContainer.IsConfigured
-            && (m_WavelengthPeakContainer.Peaks.cols() != peakSample.size())
+            && (m_WavelengthPeakContainer.Peaks.cols() != sample.Values.size())
         )
         {
-            m_WavelengthPeakContainer.Configure(peakSample.size(), m_WavelengthPeakContainer.NumSamples);
+            m_WavelengthPeakContainer.Configure(sample.Values.size(), m_WavelengthPeakContainer.NumSamples);
         }
 
-        m_WavelengthPeakContainer.Update(peakSample);
+        AddPeakSample(sample.Time, sample.Values);
+        m_ResamplingGap = sample.IsGap;
+    }
+    m_NumberOfGapSamples = m_Resampler.GetNumberOfGapSamples();
+
+    return samples.empty() ? std::numeric_limits<double>::quiet_NaN() : samples.back().Time;
+}
+
+void mtsFBGTool::AddPeakSample(const double time, const vctDoubleVec& peaks)
+{
+    // outliers are replaced in the raw peaks, so the mean, the filters and the estimator never see them
+    if (m_OutlierFilter.IsEnabled())
+    {
+        m_CleanPeaks.ForceAssign(peaks);
+        m_OutlierFilter.Process(m_CleanPeaks);
+        m_NumberOfOutliers = m_OutlierFilter.GetNumberOfOutliers();
+        m_WavelengthPeakContainer.Update(m_CleanPeaks);
     }
+    else
+        m_WavelengthPeakContainer.Update(peaks);
 
-    if (!m_WavelengthPeakContainer.IsFull)
+    UpdateTare(time, m_OutlierFilter.IsEnabled() ? m_CleanPeaks : peaks);
+
+    if (!m_WavelengthFilters.IsEnabled() && !m_Estimator.IsEnabled())
         return;
-    
+
+    // the container holds the previous value of FBGs without a peak
+    size_t row = (m_WavelengthPeakContainer.CurrentIndex + m_WavelengthPeakContainer.NumSamples - 1) % m_WavelengthPeakContainer.NumSamples;
+    m_NewestPeaks.SetSize(m_WavelengthPeakContainer.Peaks.cols());
+    for (size_t i = 0; i < m_NewestPeaks.size(); i++)
+        m_NewestPeaks[i] = m_WavelengthPeakContainer.Peaks.Element(row, i);
+
+    m_WavelengthShifts = m_FBGTool->ProcessWavelengthSamples(m_NewestPeaks);
+    if (m_WavelengthFilters.IsEnabled())
+        m_WavelengthFilters.Process(m_WavelengthShifts);
+
+    if (m_Estimator.IsEnabled())
+        m_Estimator.Update(time, m_WavelengthShifts);
+}
+
+void mtsFBGTool::Tare()
+{
+    // the statistics are sized by the first frame
+    m_TareActive    = true;
+    m_TareNumFrames = 0;
+    m_TareLastTime  = std::numeric_limits<double>::quiet_NaN();
+
+    CMN_LOG_CLASS_RUN_VERBOSE << "Tare: averaging the next " << m_TareNumSamples << " frames" << std::endl;
+}
+
+void mtsFBGTool::UpdateTare(const double time, const vctDoubleVec& peaks)
+{
+    // the peak container may read the same frame several times in one run
+    if (!m_TareActive.Data || time == m_TareLastTime)
+        return;
+
+    m_TareLastTime = time;
+    if (m_TareNumFrames == 0)
+        m_TareStatistics.Reset(peaks.size());
+
+    m_TareStatistics.Add(peaks);
+    if (++m_TareNumFrames < m_TareNumSamples)
+        return;
+
+    m_TareActive = false;
+
+    mtsDoubleVec baseWavelengths = m_FBGTool->GetBaseWavelengths();
+    if (baseWavelengths.size() != m_TareStatistics.GetNumberOfChannels())
+    {
+        CMN_LOG_CLASS_RUN_ERROR << "Tare: " << m_TareStatistics.GetNumberOfChannels() << " peaks for "
+                                << baseWavelengths.size() << " base wavelengths, keeping the base wavelengths"
+                                << std::endl;
+        return;
+    }
+
+    // FBGs without a peak during the whole tare keep their base wavelength
+    m_NoiseFloor.SetSize(baseWavelengths.size());
+    for (size_t i = 0; i < baseWavelengths.size(); i++)
+    {
+        if (m_TareStatistics.GetCount(i) == 0)
+            CMN_LOG_CLASS_RUN_WARNING << "Tare: no peak for FBG " << i << ", keeping its base wavelength" << std::endl;
+        else
+            baseWavelengths[i] = m_TareStatistics.GetMean(i);
+
+        m_NoiseFloor[i] = m_TareStatistics.GetStandardDeviation(i);
+    }
+
+    // swapped between two estimates on this task's thread, so no estimate mixes the two bases;
+    // the same peaks processed with both bases give the change of the shifts
+    vctDoubleVec shiftsOffset = m_FBGTool->ProcessWavelengthSamples(baseWavelengths);
+    m_FBGTool->SetBaseWavelengths(baseWavelengths);
+    m_BaseWavelengths = baseWavelengths;
+    shiftsOffset = m_FBGTool->ProcessWavelengthSamples(baseWavelengths) - shiftsOffset;
+
+    // the filters restart from the new zero instead of settling to it, and the estimator
+    // carries on from it, so the forces keep coming without a transient
+    m_WavelengthFilters.Reset();
+    m_Estimator.AddOffset(shiftsOffset);
+    m_ForceFilters.Reset();
+
+    CMN_LOG_CLASS_RUN_VERBOSE << "Tare: new base wavelengths from " << m_TareNumFrames << " frames" << std::endl;
+    m_TareCompletedEvent(m_NoiseFloor);
+}
+
+void mtsFBGTool::Run()
+{
+    ProcessQueuedCommands();
+    ProcessQueuedEvents();
+
+    // nothing to estimate without a configured tool
+    if (!m_FBGTool)
+        return;
+
+    double sampleTime = UpdatePeakSamples();
+    if (std::isnan(sampleTime))
+        return;
+
     // Handle forces
-    mtsDoubleVec processedPeaks = m_FBGTool->ProcessWavelengthSamples(m_WavelengthPeakContainer.Peaks);
-    mtsDouble    timestamp      = mtsTaskManager::GetInstance()->GetTimeServer().GetAbsoluteTimeInSeconds();
+    mtsDoubleVec processedPeaks;
+    if (m_Estimator.IsEnabled())
+    {
+        if (!m_Estimator.IsReady())
+            return;
+
+        processedPeaks.ForceAssign(m_Estimator.GetEstimate());
+    }
+    else if (m_WavelengthFilters.IsEnabled())
+    {
+        if (m_WavelengthShifts.size() == 0)
+            return;
+
+        processedPeaks.ForceAssign(m_WavelengthShifts);
+    }
+    else
+    {
+        if (!m_WavelengthPeakContainer.IsFull)
+            return;
+
+        processedPeaks = m_FBGTool->ProcessWavelengthSamples(m_WavelengthPeakContainer.Peaks);
+    }
+    mtsDouble    timestamp      = sampleTime;
+
+    // linear, so compensating the mean or the estimate equals compensating every frame
+    if (m_TemperatureCompensation.IsEnabled())
+    {
+        m_TemperatureCompensation.Process(processedPeaks);
+        m_CommonModeShifts.ForceAssign(m_TemperatureCompensation.GetCommonModes());
+    }
     
     
     m_ForcesTip    = m_FBGTool->GetForcesTip(processedPeaks);
     m_ForcesSclera = m_FBGTool->GetForcesSclera(processedPeaks);
 
+    if (m_ForceFilters.IsEnabled())
+    {
+        size_t numTip = m_ForcesTip.size();
+        if (m_ForceSample.size() != numTip + m_ForcesSclera.size())
+            m_ForceSample.SetSize(numTip + m_ForcesSclera.size());
+
+        std::copy(m_ForcesTip.begin(),    m_ForcesTip.end(),    m_ForceSample.begin());
+        std::copy(m_ForcesSclera.begin(), m_ForcesSclera.end(), m_ForceSample.begin() + numTip);
+        m_ForceFilters.Process(m_ForceSample);
+        std::copy(m_ForceSample.begin(), m_ForceSample.begin() + numTip, m_ForcesTip.begin());
+        std::copy(m_ForceSample.begin() + numTip, m_ForceSample.end(),   m_ForcesSclera.begin());
+    }
+
     m_ForcesTipNorm    = m_FBGTool->GetForcesTipNorm(m_ForcesTip);
     m_ForcesScleraNorm = m_FBGTool->GetForcesScleraNorm(m_ForcesSclera);
 
@@ -229,4 +497,24 @@ void mtsFBGTool::Run()
 
     m_ForcesScleraCF[0] = m_ForcesSclera[0];
     m_ForcesScleraCF[1] = m_ForcesSclera[1];
+
+    // in-process consumers get the estimate before anything is queued for the mts ones
+    m_Estimate.Time             = sampleTime;
+    m_Estimate.ForcesTip        = m_ForcesTipCF;
+    m_Estimate.ForcesSclera     = m_ForcesScleraCF;
+    m_Estimate.ForcesTipNorm    = m_ForcesTipNorm.Data;
+    m_Estimate.ForcesScleraNorm = m_ForcesScleraNorm.Data;
+    m_EstimateSubscribers.Notify(m_Estimate);
+
+    // hand every estimate to the event consumers (e.g. batched publishers)
+    m_ForcesTipSample.SetSize(m_ForcesTipCF.size());
+    m_ForcesScleraSample.SetSize(m_ForcesScleraCF.size());
+    std::copy(m_ForcesTipCF.begin(),    m_ForcesTipCF.end(),    m_ForcesTipSample.begin());
+    std::copy(m_ForcesScleraCF.begin(), m_ForcesScleraCF.end(), m_ForcesScleraSample.begin());
+
+    m_ForcesTipSample.SetTimestamp(sampleTime);
+    m_ForcesScleraSample.SetTimestamp(sampleTime);
+
+    m_ForcesTipSampleEvent(m_ForcesTipSample);
+    m_ForcesScleraSampleEvent(m_ForcesScleraSample);
 }
\ No newline at end of file
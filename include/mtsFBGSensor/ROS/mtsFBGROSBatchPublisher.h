@@ -0,0 +1,106 @@
+#ifndef _MTSFBGROSBATCHPUBLISHER_H
+#define _MTSFBGROSBATCHPUBLISHER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cisstMultiTask.h>
+
+#include <ros/ros.h>
+
+#include <mts_fbg_sensor/FBGSampleBatch.h>
+#include <mts_fbg_sensor/WrenchStampedBatch.h>
+
+/*
+ * Publishes every sample of per-sample events (e.g. "FBGPeaksSample") in batches.
+ *
+ * Each batch subscribes to a write event carrying a time stamped mtsDoubleVec; the samples
+ * are queued in the required interface's mailbox between runs and published together once
+ * per period. The mailboxes hold twice the samples of a period at the expected sample rate,
+ * so no sample is lost as long as the sensor does not run faster; a period that fills a
+ * mailbox (cisst then drops the events) is counted and logged. Samples keep the time stamps
+ * of their events (the synchronized acquisition time).
+ */
+class CISST_EXPORT mtsFBGROSBatchPublisher : public mtsTaskPeriodic
+{
+    CMN_DECLARE_SERVICES(CMN_NO_DYNAMIC_CREATION, CMN_LOG_LOD_RUN_ERROR);
+
+public:
+    // sampleRate is the highest expected rate of the sample events [Hz]
+    mtsFBGROSBatchPublisher(const std::string& componentName, const double period, const double sampleRate, ros::NodeHandle* node);
+    ~mtsFBGROSBatchPublisher() {}
+
+    // maxSamplesPerPeriod sizes the event queue (0: from the sample rate and the period)
+    void AddVectorBatch(
+        const std::string& interfaceName,
+        const std::string& eventName,
+        const std::string& topic,
+        const size_t       maxSamplesPerPeriod = 0
+    );
+
+    // events carry [Fx, Fy, Fz, Tx, Ty, Tz]
+    void AddWrenchBatch(
+        const std::string& interfaceName,
+        const std::string& eventName,
+        const std::string& topic,
+        const std::string& frameId             = "",
+        const size_t       maxSamplesPerPeriod = 0
+    );
+
+    // periods in which a mailbox was full, so samples may have been dropped
+    inline size_t GetNumberOfOverflows() const { return m_NumberOfOverflows; }
+
+    void Configure(const std::string& CMN_UNUSED(filename) = "") override {}
+    void Startup(void) override {}
+    void Run(void) override;
+    void Cleanup(void) override {}
+
+protected:
+    // the events of all batches of a required interface share its mailbox
+    struct MailBox
+    {
+        mtsInterfaceRequired* Interface  = nullptr;
+        size_t                Size       = 0;
+        size_t                NumSamples = 0; // received this period
+    };
+
+    class VectorBatch
+    {
+    public:
+        void Append(const mtsDoubleVec& sample);
+
+        ros::Publisher                 Publisher;
+        mts_fbg_sensor::FBGSampleBatch Message;
+        MailBox*                       Box = nullptr;
+    };
+
+    class WrenchBatch
+    {
+    public:
+        void Append(const mtsDoubleVec& sample);
+
+        ros::Publisher                     Publisher;
+        mts_fbg_sensor::WrenchStampedBatch Message;
+        std::string                        FrameId;
+        MailBox*                           Box = nullptr;
+    };
+
+    // the interface's mailbox, grown by the samples of one more batch
+    MailBox* GetBatchMailBox(const std::string& interfaceName, const size_t maxSamplesPerPeriod);
+
+    ros::NodeHandle* m_Node;
+    double           m_SampleRate;
+
+    std::map<std::string, MailBox> m_MailBoxes;
+    size_t                         m_NumberOfOverflows = 0;
+
+    std::vector<std::unique_ptr<VectorBatch>> m_VectorBatches;
+    std::vector<std::unique_ptr<WrenchBatch>> m_WrenchBatches;
+
+}; // class: mtsFBGROSBatchPublisher
+
+CMN_DECLARE_SERVICES_INSTANTIATION(mtsFBGROSBatchPublisher);
+
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <cisstCommon.h>
+#include <cisstVector.h>
+
+/*
+ * Removes the common-mode (temperature) shift of groups of FBGs from every frame of
+ * wavelength shifts, ahead of the calibration matrices.
+ *
+ * Configured from a "Temperature_Compensation" JSON block:
+ *   {"Groups": [
+ *       {"Indices": [0, 3, 6]},                                  the group's mean
+ *       {"Indices": [1, 4, 7], "Reference_Index": 9, "Gain": 1.2} a strain-free reference FBG
+ *   ]}
+ * Every FBG of "Indices" has "Gain" (default 1) times the group's common mode subtracted:
+ * the mean of the group's own shifts (co-located gratings whose bending shifts cancel) or the
+ * shift of the reference FBG ("Gain" is then the ratio of the temperature sensitivities).
+ *
+ * The common modes of all groups are computed together: the sources are gathered into rows
+ * of one value per group (padded to the SIMD width) and weighted and summed a row at a time.
+ */
+class CISST_EXPORT CommonModeCompensator
+{
+public:
+    // configure from the "Temperature_Compensation" JSON block
+    void Configure(const Json::Value& jsonConfig);
+
+    inline bool   IsEnabled()         const { return m_Enabled; }
+    inline size_t GetNumberOfGroups() const { return m_Groups.size(); }
+
+    // builds the gather tables; disables the compensation if an index is out of range
+    void SetNumberOfChannels(const size_t numChannels);
+
+    // compensate one frame of shifts in place; a new size rebuilds the tables
+    void Process(vctDoubleVec& shifts);
+
+    // common mode of every group in the last frame
+    inline const vctDoubleVec& GetCommonModes() const { return m_CommonModes; }
+
+protected:
+    struct Group
+    {
+        std::vector<size_t> Indices;
+        int                 ReferenceIndex = -1; // the group's mean without one
+        double              Gain           = 1.0;
+    };
+
+    // configuration
+    bool               m_Enabled = false;
+    std::vector<Group> m_Groups;
+
+    // gather tables: row r of one source index and weight per group
+    size_t              m_NumChannels = 0;
+    size_t              m_NumRows     = 0;
+    size_t              m_Stride      = 0; // groups padded to the SIMD width
+    std::vector<size_t> m_SourceIndices;
+    std::vector<double> m_SourceWeights;
+    std::vector<double> m_Sources;
+    std::vector<double> m_Sums;
+
+    // scatter table: (shift, group) per compensated FBG
+    std::vector<std::pair<size_t, size_t>> m_Targets;
+
+    vctDoubleVec m_CommonModes;
+
+}; // class: CommonModeCompensator
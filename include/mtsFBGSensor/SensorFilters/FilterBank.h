@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cisstCommon.h>
+#include <cisstVector.h>
+
+/*
+ * Cascade of linear filter stages applied to every channel of a vector signal (e.g. the
+ * wavelength shifts or the forces of a tool), one sample at a time.
+ *
+ * Configured from a JSON block {"Enabled": true, "Sample_Rate": 1000, "Stages": [...]} whose
+ * stages run in order:
+ *   {"Type": "Lowpass",  "Frequency": 20.0, "Order": 2}     Butterworth (even order)
+ *   {"Type": "Highpass", "Frequency": 0.05, "Order": 2}     Butterworth (even order)
+ *   {"Type": "Lowpass",  "Frequency": 20.0, "Q": 0.5}       single biquad of the given Q
+ *   {"Type": "Bandpass", "Frequency": 5.0,  "Q": 2.0}       single biquad, unit peak gain
+ *   {"Type": "Notch",    "Frequency": 0.25, "Bandwidth": 0.1, "Harmonics": 1}
+ *       notch per harmonic of the frequency, of the given -3 dB bandwidth [Hz] or "Q"
+ *   {"Type": "Biquad",   "Sections": [[b0, b1, b2, a1, a2], ...]}   coefficients with a0 = 1
+ *   {"Type": "FIR",      "Taps": [h0, h1, ...]}              y[n] = sum h[k] x[n - k]
+ *   {"Type": "Moving_Average", "Num_Samples": 20}
+ *
+ * The states are stored channel-minor (one row of every channel per state variable, padded
+ * to the SIMD width), so each filter step runs over all channels with AVX2 or NEON when the
+ * library is compiled for them. Nothing is allocated after SetNumberOfChannels() (or the first
+ * sample of a new size); the first sample after a reset sets every stage to its steady state.
+ */
+class CISST_EXPORT FilterBank
+{
+public:
+    enum class Type {
+        BIQUAD,
+        FIR,
+        MOVING_AVERAGE,
+    }; // enum: Type
+
+    struct Biquad
+    {
+        double B0, B1, B2, A1, A2;
+    };
+
+    // configure from a filter JSON block; returns false (and disables the bank) on an invalid stage
+    bool Configure(const Json::Value& jsonConfig);
+
+    inline bool   IsEnabled()           const { return m_Enabled; }
+    inline double GetSampleRate()       const { return m_SampleRate; }
+    inline size_t GetNumberOfStages()   const { return m_Stages.size(); }
+    inline size_t GetNumberOfChannels() const { return m_NumChannels; }
+
+    // e.g. "Notch (0.25 Hz) > Lowpass (order 2, 20 Hz)"
+    std::string GetDescription() const;
+
+    // allocates the states; the only allocation of the bank after Configure()
+    void SetNumberOfChannels(const size_t numChannels);
+
+    // restarts from the next sample's steady state
+    void Reset();
+
+    // filter one sample of every channel (input and output may be the same)
+    void Process(const double* input, double* output);
+
+    // filter one sample in place; a new size reallocates the states and resets
+    void Process(vctDoubleVec& samples);
+
+    // Butterworth design as second-order sections (bilinear transform, prewarped at the cutoff)
+    static std::vector<Biquad> DesignButterworth(const size_t order, const double cutoff, const double sampleRate,
+                                                 const bool isHighpass = false);
+
+protected:
+    struct Stage
+    {
+        Type                Kind = Type::BIQUAD;
+        std::string         Description;
+        std::vector<Biquad> Sections;       // biquad
+        std::vector<double> Taps;           // FIR
+        size_t              NumSamples = 1; // moving average
+        size_t              StateOffset = 0; // into m_States
+        size_t              Position    = 0; // FIR history or moving average ring position
+    };
+
+    bool AddStage(const Json::Value& jsonStage);
+
+    // sets the stage to the steady state of the sample and replaces it with the stage's output
+    void PrimeStage(Stage& stage, double* sample);
+    void ProcessBiquad(Stage& stage, double* samples);
+    void ProcessFIR(Stage& stage, double* samples);
+    void ProcessMovingAverage(Stage& stage, double* samples);
+
+    // configuration
+    bool               m_Enabled    = false;
+    double             m_SampleRate = 1000.0; // [Hz]
+    std::vector<Stage> m_Stages;
+
+    // states, one row of m_Stride values per state variable
+    size_t              m_NumChannels = 0;
+    size_t              m_Stride      = 0; // channels padded to the SIMD width
+    std::vector<double> m_States;
+    std::vector<double> m_Work;          // the sample being filtered (one row)
+    bool                m_IsPrimed = false;
+
+}; // class: FilterBank
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cisstCommon.h>
+#include <cisstVector.h>
+
+#include "mtsFBGSensor/Utilities/OrderStatisticTreap.h"
+
+/*
+ * Causal Hampel filter: every channel's new sample is compared with the median of its last
+ * "Window" samples and replaced when it deviates by more than "Threshold" scaled MADs
+ * (1.4826 x the median absolute deviation, the standard deviation of Gaussian noise).
+ *
+ * Configured from an "Outlier_Filter" JSON block:
+ *   {"Window": 21, "Threshold": 3.0, "Min_Deviation": 1e-4, "Replacement": "Median"}
+ * where "Min_Deviation" [signal units] keeps quantized, nearly constant signals (MAD of 0)
+ * from being flagged and "Replacement" is "Median" or "Previous" (the channel's last output).
+ *
+ * The window keeps the raw samples, so a lasting step passes once it fills half the window.
+ * Each channel's window is an order-statistic treap: sliding it is O(log n), the median
+ * O(log n) and the MAD O(log^2 n) (a selection over the deviations below and above the
+ * median), only needed when quartile bounds on the MAD do not settle the sample; nothing is
+ * allocated after the first sample. Missing samples (NaN) pass unchanged
+ * and are left out of the window.
+ */
+class CISST_EXPORT HampelFilter
+{
+public:
+    enum class Replacement {
+        MEDIAN,
+        PREVIOUS,
+    }; // enum: Replacement
+
+    // configure from the "Outlier_Filter" JSON block
+    void Configure(const Json::Value& jsonConfig);
+
+    inline bool   IsEnabled() const { return m_Enabled; }
+    inline size_t GetWindow() const { return m_Window; }
+
+    // allocates the windows; a new size in Process() does the same
+    void SetNumberOfChannels(const size_t numChannels);
+
+    // empties the windows
+    void Reset();
+
+    // filter one sample in place; returns the number of values replaced
+    size_t Process(vctDoubleVec& samples);
+
+    // values replaced since the last reset
+    inline size_t GetNumberOfOutliers() const { return m_NumOutliers; }
+
+    // statistics of a channel's window (NaN until the window is full)
+    double GetMedian(const size_t channel) const;
+    double GetMedianAbsoluteDeviation(const size_t channel) const;
+
+protected:
+    struct Channel
+    {
+        OrderStatisticTreap<double> Sorted;
+        std::vector<double>         Ring;         // the window's samples in arrival order
+        size_t                      Position = 0;
+        double                      Previous = 0.0; // last output
+    };
+
+    static double Median(const Channel& channel);
+    static double MedianAbsoluteDeviation(const Channel& channel, const double median);
+    static void   MedianAbsoluteDeviationBounds(const Channel& channel, const double median, double& lower, double& upper);
+
+    // configuration
+    bool        m_Enabled      = false;
+    size_t      m_Window       = 21;
+    double      m_Threshold    = 3.0;
+    double      m_MinDeviation = 1e-4;
+    Replacement m_Replacement  = Replacement::MEDIAN;
+
+    // state
+    std::vector<Channel> m_Channels;
+    size_t               m_NumOutliers = 0;
+
+}; // class: HampelFilter
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <cisstCommon.h>
+#include <cisstVector.h>
+
+#include "FilterBank.h"
+
+/*
+ * Causal estimate of a vector signal (e.g. the wavelength shifts of a tool) from its samples,
+ * every element filtered independently.
+ *
+ * Configured from an "Estimator" JSON block with one of the types:
+ *   {"Type": "Boxcar",      "Num_Samples": 200}
+ *       mean of the last samples; (Num_Samples - 1) / 2 samples of delay
+ *   {"Type": "Kalman",      "Model": "Constant_Velocity", "Process_Noise": 1e-3, "Measurement_Noise": 1e-6}
+ *       Kalman filter per element on a random walk ("Random_Walk", Process_Noise in [unit^2/s])
+ *       or on position and rate ("Constant_Velocity", Process_Noise in [unit^2/s^3]), the
+ *       latter tracking ramps without lag; Measurement_Noise is the variance of one sample
+ *   {"Type": "Butterworth", "Order": 2, "Cutoff_Frequency": 20.0}
+ *       low-pass of even order as a cascade of biquads, starting from the first sample's steady state
+ *
+ * "Sample_Rate" [Hz] (default 1000) is the nominal rate of the samples: the Butterworth
+ * design uses it, the Kalman filter uses it whenever two timestamps do not give a valid step.
+ */
+class CISST_EXPORT SignalEstimator
+{
+public:
+    enum class Type {
+        BOXCAR,
+        KALMAN,
+        BUTTERWORTH,
+    }; // enum: Type
+
+    // configure from the "Estimator" JSON block
+    void Configure(const Json::Value& jsonConfig);
+
+    inline bool IsEnabled() const { return m_Enabled; }
+    inline Type GetType()   const { return m_Type; }
+
+    // e.g. "Butterworth (order 2, 20 Hz)"
+    std::string GetDescription() const;
+
+    // restarts from the next sample (whose size sets the signal's)
+    void Reset();
+
+    // shifts the state as if every past sample had been offset (e.g. by a new zero), so the
+    // estimate stays ready and continuous; ignored before the first sample or on a size mismatch
+    void AddOffset(const vctDoubleVec& offset);
+
+    // feed one sample; returns true once the estimate is valid
+    bool Update(const double time, const vctDoubleVec& sample);
+
+    inline bool                IsReady()     const { return m_IsReady; }
+    inline const vctDoubleVec& GetEstimate() const { return m_Estimate; }
+
+protected:
+    typedef FilterBank::Biquad Biquad;
+
+    void UpdateBoxcar(const vctDoubleVec& sample);
+    void UpdateKalman(const double time, const vctDoubleVec& sample);
+    void UpdateButterworth(const vctDoubleVec& sample);
+
+    // configuration
+    bool        m_Enabled          = false;
+    Type        m_Type             = Type::BOXCAR;
+    double      m_SampleRate       = 1000.0; // [Hz]
+    size_t      m_NumSamples       = 200;
+    bool        m_ConstantVelocity = true;
+    double      m_ProcessNoise     = 1e-3;
+    double      m_MeasurementNoise = 1e-6;
+    size_t      m_Order            = 2;
+    double      m_CutoffFrequency  = 20.0; // [Hz]
+
+    // state
+    bool         m_IsReady    = false;
+    size_t       m_NumUpdates = 0;
+    vctDoubleVec m_Estimate;
+
+    // boxcar: ring of the last samples and their running sum
+    vctDoubleMat m_Window;
+    vctDoubleVec m_WindowSum;
+
+    // Kalman: per element rate and covariance [P00, P01; P01, P11]
+    double       m_LastTime = std::numeric_limits<double>::quiet_NaN();
+    vctDoubleVec m_Rate;
+    vctDoubleMat m_Covariance; // one row [P00, P01, P11] per element
+
+    // Butterworth: sections and their transposed direct form II states
+    std::vector<Biquad> m_Sections;
+    vctDoubleMat        m_SectionStates; // two columns per section, one row per element
+
+}; // class: SignalEstimator
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <cisstCommon.h>
+#include <cisstVector.h>
+
+// One sample of the resampled stream
+struct UniformSample
+{
+    double       Time;   // grid time [s]
+    vctDoubleVec Values;
+    bool         IsGap;  // interpolated across a gap in the input (dropped sweeps or a stall)
+
+}; // struct: UniformSample
+
+/*
+ * Resamples an irregularly timed vector stream onto a uniform time grid.
+ *
+ * Input samples are keyed by their (hardware) timestamps; repeated or older timestamps are
+ * ignored, so the latest state can be polled faster than it updates. Grid samples are
+ * produced once the input brackets them: linear interpolation uses the two neighbours,
+ * cubic interpolation a Hermite spline with slopes from the neighbours' neighbours (one
+ * more input sample of delay). A grid sample whose bracketing input interval is longer
+ * than "Max_Gap" is flagged; an interval longer than "Reset_Gap" restarts the grid.
+ */
+class CISST_EXPORT UniformResampler
+{
+public:
+    enum class Method {
+        LINEAR,
+        CUBIC,
+    }; // enum: Method
+
+    // configure from the "Resampling" JSON block
+    void Configure(const Json::Value& jsonConfig);
+
+    inline bool   IsEnabled() const { return m_Enabled; }
+    inline double GetPeriod() const { return m_Period; }
+    inline double GetRate()   const { return 1.0 / m_Period; }
+
+    void Reset();
+
+    // add one input sample; returns false if its timestamp is not newer than the last one
+    bool AddSample(const double time, const vctDoubleVec& values);
+
+    // grid samples completed since the last call (the vector is reused)
+    const std::vector<UniformSample>& GetUniformSamples();
+
+    inline size_t GetNumberOfGapSamples() const { return m_NumGapSamples; }
+
+protected:
+    struct InputSample
+    {
+        double       Time;
+        vctDoubleVec Values;
+    };
+
+    void Interpolate(const double time, UniformSample& sample) const;
+
+    // configuration
+    bool   m_Enabled  = false;
+    Method m_Method   = Method::LINEAR;
+    double m_Period   = 0.001;  // [s]
+    double m_MaxGap   = 0.0025; // [s]
+    double m_ResetGap = 0.1;    // [s]
+
+    // state
+    std::deque<InputSample>    m_Inputs;           // the last few input samples, oldest first
+    double                     m_NextTime = 0.0;   // next grid time [s]
+    bool                       m_HasGrid  = false;
+    std::vector<UniformSample> m_Outputs;
+    size_t                     m_NumOutputs    = 0;
+    size_t                     m_NumGapSamples = 0;
+
+}; // class: UniformResampler
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cisstCommon.h>
+
+// Peak found in one FBG window of a calibrated spectrum
+struct SpectrumPeak
+{
+    double Wavelength = 0.0; // sub-pixel peak wavelength [nm] (NaN if not detected)
+    double Amplitude  = 0.0; // fitted peak power [dBm]
+    size_t Index      = 0;   // spectrum sample closest to the peak
+    bool   Valid      = false;
+
+    // signal quality (NaN when it cannot be measured within the window)
+    double FWHM       = 0.0; // full width at half maximum [nm]
+    double SNR        = 0.0; // peak power above the window's noise floor [dB]
+    double Asymmetry  = 0.0; // (right - left half width) / FWHM, 0 for a symmetric peak
+
+}; // struct: SpectrumPeak
+
+// Wavelength range in which one FBG is expected on a channel
+struct SpectrumPeakWindow
+{
+    size_t Channel;       // 1-based channel number
+    double WavelengthMin; // [nm]
+    double WavelengthMax; // [nm]
+
+}; // struct: SpectrumPeakWindow
+
+/*
+ * Software peak detection on calibrated (dBm) spectra.
+ *
+ * Each configured FBG window is thresholded and its maximum refined to sub-pixel
+ * resolution with one of:
+ *   CENTROID:  power-weighted centroid of the samples within Centroid_Level dB of the maximum
+ *   GAUSSIAN:  three-point parabola on the dB samples (a Gaussian in linear power)
+ *   PARABOLIC: three-point parabola on the linear power samples
+ *
+ * With tracking enabled, a window whose FBG was found in the previous frame is only
+ * searched within Half_Width of the previous peak. The FBG is re-acquired from the full
+ * window when the narrow search loses it (below threshold, or the maximum lies on the
+ * edge of the narrow range). Each FBG keeps its slot in GetPeaks() either way.
+ *
+ * Along with each peak, its FWHM (interpolated -3 dB crossings), asymmetry and SNR against
+ * the noise floor at the window's edges are measured; this only touches the samples
+ * of the peak itself, so it keeps the cost of tracking.
+ *
+ * Channels are processed in parallel by a pool of worker threads; the calling thread
+ * takes part so a single-threaded configuration has no synchronization overhead.
+ */
+class CISST_EXPORT SpectrumPeakDetector
+{
+public:
+    enum class FitMethod {
+        CENTROID,
+        GAUSSIAN,
+        PARABOLIC,
+    }; // enum: FitMethod
+
+    SpectrumPeakDetector() = default;
+    ~SpectrumPeakDetector();
+
+    SpectrumPeakDetector(const SpectrumPeakDetector&)            = delete;
+    SpectrumPeakDetector& operator=(const SpectrumPeakDetector&) = delete;
+
+    // configure from the "Peak_Detection" JSON block
+    void Configure(const Json::Value& jsonConfig);
+
+    void SetWindows(const std::vector<SpectrumPeakWindow>& windows);
+    void SetThreshold(const double threshold)  { m_Threshold = threshold; }
+    void SetFitMethod(const FitMethod method)  { m_FitMethod = method; }
+    void SetNumberOfThreads(const size_t numThreads);
+    void SetTracking(const bool enabled, const double halfWidth);
+
+    // drop all locks so the next frame searches the full windows
+    void ResetTracking();
+
+    // layout of the spectra passed to Detect: numChannels blocks of numPoints samples
+    void SetScan(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels);
+    bool IsScanSet(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels) const;
+
+    // detect one peak per window in a channel-major calibrated spectrum
+    void Detect(const double* spectrum);
+
+    inline const std::vector<SpectrumPeak>&       GetPeaks()   const { return m_Peaks; }
+    inline const std::vector<SpectrumPeakWindow>& GetWindows() const { return m_Windows; }
+    inline size_t GetNumberOfPeaks() const { return m_Peaks.size(); }
+
+    inline bool   IsTracking() const { return m_TrackingEnabled; }
+    size_t GetNumberOfLockedPeaks() const;
+    size_t GetNumberOfReacquisitions() const;
+
+protected:
+    // window converted to sample indices of the current scan
+    struct WindowRange
+    {
+        size_t Begin;
+        size_t End;
+    };
+
+    // lock on the FBG of one window, updated only by the thread processing its channel
+    struct PeakTrack
+    {
+        bool   Locked = false;
+        size_t Index  = 0;     // sample of the maximum in the previous frame
+        size_t NumReacquisitions = 0;
+    };
+
+    // windows of one channel, processed together by one thread
+    struct ChannelTask
+    {
+        size_t Channel;
+        std::vector<size_t> WindowIndices;
+    };
+
+    void DetectChannel(const ChannelTask& task);
+    void DetectWindow(const double* channelSpectrum, const size_t windowIndex);
+
+    // maximum of [begin, end); returns -inf for an empty range
+    double FindMaximum(const double* channelSpectrum, const size_t begin, const size_t end, size_t& maxIndex) const;
+    void   MeasureQuality(const double* channelSpectrum, const WindowRange& range, const double peakIndex, SpectrumPeak& peak) const;
+    double FitPeak(const double* channelSpectrum, const size_t begin, const size_t end, const size_t maxIndex, double& amplitude) const;
+
+    void ProcessChannels();
+    void WorkerLoop();
+    void StopWorkers();
+
+    // configuration
+    std::vector<SpectrumPeakWindow> m_Windows;
+    double    m_Threshold     = -40.0; // minimum peak power [dBm]
+    double    m_CentroidLevel = 3.0;   // [dB] below the maximum
+    size_t    m_NoiseSamples  = 8;     // samples at each end of a window for its noise floor
+    FitMethod m_FitMethod     = FitMethod::GAUSSIAN;
+    size_t    m_NumThreads    = 1;
+    bool      m_TrackingEnabled   = false;
+    double    m_TrackingHalfWidth = 0.05;  // [nm] around the previous peak
+
+    // scan layout
+    double m_StartWavelength = 0.0;
+    double m_DeltaWavelength = 0.0;
+    size_t m_NumPoints       = 0;
+    size_t m_NumChannels     = 0;
+
+    std::vector<WindowRange>  m_Ranges;
+    std::vector<PeakTrack>    m_Tracks;
+    size_t                    m_TrackingHalfWidthPoints = 0;
+    std::vector<ChannelTask>  m_ChannelTasks;
+    std::vector<SpectrumPeak> m_Peaks;
+
+    // worker pool
+    const double*            m_Spectrum = nullptr;
+    std::vector<std::thread> m_Workers;
+    std::mutex               m_Mutex;
+    std::condition_variable  m_WorkCondition;
+    std::condition_variable  m_DoneCondition;
+    size_t                   m_Generation = 0;
+    bool                     m_Stop       = false;
+    std::atomic<size_t>      m_NextTask{0};
+    std::atomic<size_t>      m_NumPending{0};
+
+}; // class: SpectrumPeakDetector
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cisstCommon.h>
+
+/*
+ * On-disk layout of a spectrum recording directory:
+ *
+ *   spectra.index      SpectrumRecordingHeader followed by MaxSweeps SpectrumRecordingEntry
+ *   channel_<N>.raw    MaxSweeps rows of NumPoints uint16 raw samples of channel N (1-based)
+ *
+ * All files are preallocated to their full size when the recording is opened. NumSweeps in the
+ * header is only advanced once a sweep has been written to every channel file.
+ */
+struct SpectrumRecordingHeader
+{
+    char     Magic[8];            // "FBGSPEC"
+    uint32_t Version;
+    uint32_t NumChannels;
+    uint32_t NumPoints;
+    uint32_t Reserved;
+    uint64_t MaxSweeps;
+    uint64_t NumSweeps;
+    double   StartWavelength;     // [nm]
+    double   WavelengthIncrement; // [nm]
+
+}; // struct: SpectrumRecordingHeader
+
+struct SpectrumRecordingEntry
+{
+    uint64_t SerialNumber;
+    double   Timestamp; // instrument time [s]
+
+}; // struct: SpectrumRecordingEntry
+
+// Read-write or read-only memory mapping of a whole file
+class SpectrumMappedFile
+{
+public:
+    SpectrumMappedFile() = default;
+    ~SpectrumMappedFile() { Unmap(); }
+
+    SpectrumMappedFile(const SpectrumMappedFile&)            = delete;
+    SpectrumMappedFile& operator=(const SpectrumMappedFile&) = delete;
+
+    // creates and preallocates the file to size bytes when writable; throws std::runtime_error
+    void Map(const std::string& path, const size_t size, const bool writable);
+    void Unmap();
+
+    inline uint8_t* GetData() const { return m_Data; }
+    inline size_t   GetSize() const { return m_Size; }
+
+private:
+    int      m_FileDescriptor = -1;
+    uint8_t* m_Data           = nullptr;
+    size_t   m_Size           = 0;
+
+}; // class: SpectrumMappedFile
+
+/*
+ * Records raw spectra to memory-mapped per-channel files without blocking acquisition.
+ *
+ * Record() copies the sweep into a preallocated queue slot and returns; a background thread
+ * scatters the channels into their files and appends the index entry. Sweeps are dropped
+ * (and counted) when the queue is full or the recording has reached Max_Sweeps.
+ */
+class CISST_EXPORT SpectrumRecorder
+{
+public:
+    SpectrumRecorder() = default;
+    ~SpectrumRecorder();
+
+    SpectrumRecorder(const SpectrumRecorder&)            = delete;
+    SpectrumRecorder& operator=(const SpectrumRecorder&) = delete;
+
+    // configure from the "Spectrum_Recording" JSON block
+    void Configure(const Json::Value& jsonConfig);
+
+    inline bool IsEnabled() const { return m_Enabled; }
+    inline bool IsOpen()    const { return m_Writer.joinable(); }
+
+    // preallocates the files for the given scan and starts the writer; throws std::runtime_error
+    // and disables the recorder if the files cannot be created
+    void Open(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels);
+    bool IsScanSet(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels) const;
+
+    // flushes the queued sweeps and closes the files
+    void Close();
+
+    // queue one channel-major raw sweep; returns false if it was dropped
+    bool Record(const uint64_t serialNumber, const double timestamp, const uint16_t* rawSpectrum);
+
+    // directory of the current (or last) recording
+    inline const std::string& GetRecordingDirectory() const { return m_RecordingDirectory; }
+
+    inline size_t GetNumberOfRecordedSweeps() const { return m_NumRecorded; }
+    inline size_t GetNumberOfDroppedSweeps()  const { return m_NumDropped; }
+
+protected:
+    struct QueuedSweep
+    {
+        SpectrumRecordingEntry Entry;
+        std::vector<uint16_t>  Samples;
+    };
+
+    void OpenFiles(const double startWavelength, const double deltaWavelength, const size_t numPoints, const size_t numChannels);
+    void WriterLoop();
+    void WriteSweep(const QueuedSweep& sweep);
+
+    // configuration
+    bool        m_Enabled   = false;
+    std::string m_Directory = ".";
+    size_t      m_MaxSweeps = 10000;
+    size_t      m_QueueSize = 64;
+
+    // files
+    std::string                                      m_RecordingDirectory;
+    SpectrumRecordingHeader*                         m_Header  = nullptr;
+    SpectrumRecordingEntry*                          m_Entries = nullptr;
+    SpectrumMappedFile                               m_IndexFile;
+    std::vector<std::unique_ptr<SpectrumMappedFile>> m_ChannelFiles;
+
+    // single producer / single consumer queue of sweeps
+    std::vector<QueuedSweep> m_Queue;
+    std::atomic<size_t>      m_QueueHead{0}; // next slot written by Record
+    std::atomic<size_t>      m_QueueTail{0}; // next slot written to disk
+    std::atomic<bool>        m_Stop{false};
+    std::mutex               m_Mutex;
+    std::condition_variable  m_QueueCondition;
+    std::thread              m_Writer;
+
+    std::atomic<size_t> m_NumRecorded{0};
+    std::atomic<size_t> m_NumDropped{0};
+
+}; // class: SpectrumRecorder
+
+// Zero-copy access to a spectrum recording directory
+class CISST_EXPORT SpectrumRecordingReader
+{
+public:
+    SpectrumRecordingReader() = default;
+    ~SpectrumRecordingReader() { Close(); }
+
+    SpectrumRecordingReader(const SpectrumRecordingReader&)            = delete;
+    SpectrumRecordingReader& operator=(const SpectrumRecordingReader&) = delete;
+
+    // throws std::runtime_error if the directory does not hold a valid recording
+    void Open(const std::string& directory);
+    void Close();
+
+    inline size_t GetNumberOfSweeps()      const { return m_Header ? m_Header->NumSweeps : 0; }
+    inline size_t GetNumberOfChannels()    const { return m_Header ? m_Header->NumChannels : 0; }
+    inline size_t GetNumberOfPoints()      const { return m_Header ? m_Header->NumPoints : 0; }
+    inline double GetStartWavelength()     const { return m_Header ? m_Header->StartWavelength : 0.0; }
+    inline double GetWavelengthIncrement() const { return m_Header ? m_Header->WavelengthIncrement : 0.0; }
+
+    inline const SpectrumRecordingEntry& GetEntry(const size_t sweep) const { return m_Entries[sweep]; }
+
+    // views into the mapped files (channel is 1-based), valid until Close()
+    const uint16_t* GetChannel(const size_t channel) const;
+    const uint16_t* GetSpectrum(const size_t sweep, const size_t channel) const;
+
+private:
+    const SpectrumRecordingHeader*                   m_Header  = nullptr;
+    const SpectrumRecordingEntry*                    m_Entries = nullptr;
+    SpectrumMappedFile                               m_IndexFile;
+    std::vector<std::unique_ptr<SpectrumMappedFile>> m_ChannelFiles;
+
+}; // class: SpectrumRecordingReader
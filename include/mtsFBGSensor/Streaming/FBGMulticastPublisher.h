@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+
+#include <cisstCommon.h>
+
+#include "FBGStreamProtocol.h"
+
+/*
+ * Publishes the FBG streams as UDP multicast datagrams, one frame (see FBGStreamProtocol.h) per
+ * datagram, for consumers on other hosts.
+ *
+ * Push() encodes the frame into a per-stream buffer and sends it right away from the calling
+ * (producer) thread without waiting; a datagram the socket cannot take is dropped, which the
+ * receivers see as a gap in the stream's sequence numbers. Frames larger than the path MTU
+ * (about 180 values on Ethernet) are fragmented by IP.
+ *
+ * Configured from a "Multicast" JSON block:
+ *   {
+ *     "Enabled":   true,        // read by the owner to decide whether to Open() it
+ *     "Group":     "239.255.70.66",
+ *     "Port":      30100,
+ *     "Interface": "0.0.0.0",   // address of the outgoing interface (0.0.0.0 lets the routing table choose)
+ *     "TTL":       1,           // 1 keeps the datagrams on the local network
+ *     "Loopback":  false,       // also deliver to receivers on this host
+ *     "Streams":   ["Peaks", "Forces_Tip", "Forces_Sclera"]
+ *   }
+ */
+class CISST_EXPORT FBGMulticastPublisher
+{
+public:
+    FBGMulticastPublisher() = default;
+    ~FBGMulticastPublisher() { Close(); }
+
+    FBGMulticastPublisher(const FBGMulticastPublisher&)            = delete;
+    FBGMulticastPublisher& operator=(const FBGMulticastPublisher&) = delete;
+
+    void Configure(const Json::Value& jsonConfig);
+
+    // throws std::runtime_error if the socket cannot be set up
+    void Open();
+    void Close();
+
+    inline bool IsOpen() const { return m_Socket >= 0; }
+
+    // one thread per stream; returns false if the frame was not sent
+    bool Push(const FBGStream::StreamId stream, const double time, const double* values, const size_t numValues);
+
+    inline size_t GetNumberOfSentFrames()    const { return m_NumSent; }
+    inline size_t GetNumberOfDroppedFrames() const { return m_NumDropped; }
+
+private:
+    struct Stream
+    {
+        bool                IsEnabled = true;
+        uint64_t            Sequence  = 0;
+        std::vector<double> Frame; // encoded frame, 8-byte aligned
+    };
+
+    // configuration
+    std::string m_Group     = "239.255.70.66";
+    uint16_t    m_Port      = 30100;
+    std::string m_Interface = "0.0.0.0";
+    int         m_TTL       = 1;
+    bool        m_Loopback  = false;
+
+    Stream m_Streams[FBGStream::NUM_STREAMS];
+
+    int         m_Socket = -1;
+    sockaddr_in m_Destination;
+
+    std::atomic<size_t> m_NumSent{0};
+    std::atomic<size_t> m_NumDropped{0};
+
+}; // class: FBGMulticastPublisher
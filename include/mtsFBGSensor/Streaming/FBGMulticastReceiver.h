@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cisstCommon.h>
+
+#include "FBGStreamProtocol.h"
+
+/*
+ * Receives the frames of an FBGMulticastPublisher and tracks their loss.
+ *
+ * Every stream's sequence numbers are followed: a jump forward counts the skipped frames as
+ * lost, a frame older than the newest one received is counted as late and still returned
+ * (UDP may reorder), and a jump back to 0 or by more than the restart window is taken as the
+ * publisher restarting.
+ */
+class CISST_EXPORT FBGMulticastReceiver
+{
+public:
+    FBGMulticastReceiver() = default;
+    ~FBGMulticastReceiver() { Close(); }
+
+    FBGMulticastReceiver(const FBGMulticastReceiver&)            = delete;
+    FBGMulticastReceiver& operator=(const FBGMulticastReceiver&) = delete;
+
+    // joins the group on the interface with the given address (0.0.0.0 lets the system choose);
+    // throws std::runtime_error
+    void Open(const std::string& group, const uint16_t port, const std::string& interfaceAddress = "0.0.0.0");
+    void Close();
+
+    inline bool IsOpen() const { return m_Socket >= 0; }
+
+    // waits up to timeout [s] (negative waits indefinitely) for the next frame; returns false on timeout
+    bool Receive(FBGStream::FrameHeader& header, std::vector<double>& values, const double timeout = -1.0);
+
+    // loss statistics of a stream since Open() or ResetStatistics()
+    inline size_t GetNumberOfReceivedFrames(const FBGStream::StreamId stream) const { return m_Streams[stream].NumReceived; }
+    inline size_t GetNumberOfLostFrames(const FBGStream::StreamId stream)     const { return m_Streams[stream].NumLost; }
+    inline size_t GetNumberOfLateFrames(const FBGStream::StreamId stream)     const { return m_Streams[stream].NumLate; }
+    inline size_t GetNumberOfRestarts(const FBGStream::StreamId stream)       const { return m_Streams[stream].NumRestarts; }
+
+    // frames that are not valid frames of this protocol version
+    inline size_t GetNumberOfInvalidFrames() const { return m_NumInvalid; }
+
+    void ResetStatistics();
+
+    inline void SetRestartWindow(const uint64_t window) { m_RestartWindow = window; }
+
+private:
+    struct Stream
+    {
+        bool     HasSequence  = false;
+        uint64_t NextSequence = 0;
+        size_t   NumReceived  = 0;
+        size_t   NumLost      = 0;
+        size_t   NumLate      = 0;
+        size_t   NumRestarts  = 0;
+    };
+
+    void UpdateSequence(Stream& stream, const uint64_t sequence);
+
+    int                 m_Socket = -1;
+    std::vector<double> m_Buffer; // 8-byte aligned receive buffer
+    Stream              m_Streams[FBGStream::NUM_STREAMS];
+    size_t              m_NumInvalid    = 0;
+    uint64_t            m_RestartWindow = 1000;
+
+}; // class: FBGMulticastReceiver
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cisstCommon.h>
+
+#include "FBGStreamProtocol.h"
+
+// Receives the frames of an FBGStreamServer
+class CISST_EXPORT FBGStreamClient
+{
+public:
+    FBGStreamClient() = default;
+    ~FBGStreamClient() { Close(); }
+
+    FBGStreamClient(const FBGStreamClient&)            = delete;
+    FBGStreamClient& operator=(const FBGStreamClient&) = delete;
+
+    // throws std::runtime_error if the server cannot be reached
+    void Connect(const std::string& socketPath);
+    void Close();
+
+    inline bool IsConnected() const { return m_Socket >= 0; }
+
+    // replaces what the server sends to this client; no selections subscribes to everything
+    void Subscribe(const std::vector<FBGStream::Selection>& selections);
+
+    // waits up to timeout [s] (negative waits indefinitely) for the next frame; returns false on
+    // timeout and throws std::runtime_error once the server has closed the connection
+    bool Receive(FBGStream::FrameHeader& header, std::vector<double>& values, const double timeout = -1.0);
+
+private:
+    int                 m_Socket = -1;
+    std::vector<double> m_Buffer; // 8-byte aligned receive buffer
+
+}; // class: FBGStreamClient
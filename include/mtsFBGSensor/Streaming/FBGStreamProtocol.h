@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// frames are written in host byte order, which has to be the wire's
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "The FBG stream frames are little-endian and are only produced on little-endian hosts"
+#endif
+
+/*
+ * Binary frames served by the streaming outputs (little-endian):
+ *
+ *   FrameHeader (32 bytes) | NumValues x float64
+ *
+ * The values of a frame are 8-byte aligned when the frame is. Receivers must check Magic and
+ * Version; a new version is issued whenever the layout changes.
+ *
+ * A local client may narrow what it receives with a subscription request (little-endian):
+ *
+ *   SubscriptionHeader (8 bytes) | NumSelections x Selection (12 bytes)
+ *
+ * Each selection adds a range of one stream's values (the FBG slots of the peaks, the wrench
+ * components of the forces); a stream without any selection is not sent. The frames then hold
+ * the selected values in request order, and NumValues counts them.
+ */
+namespace FBGStream
+{
+    const uint32_t MAGIC   = 0x53474246; // "FBGS"
+    const uint16_t VERSION = 1;
+
+    enum StreamId : uint16_t
+    {
+        STREAM_PEAKS         = 0, // FBG peaks [nm], NaN where no peak was found
+        STREAM_FORCES_TIP    = 1, // [Fx, Fy, Fz, Tx, Ty, Tz]
+        STREAM_FORCES_SCLERA = 2, // [Fx, Fy, Fz, Tx, Ty, Tz]
+        NUM_STREAMS
+    }; // enum: StreamId
+
+    struct FrameHeader
+    {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t Stream;    // StreamId
+        uint64_t Sequence;  // per stream, incremented for every frame produced (gaps are lost frames)
+        double   Time;      // host time of acquisition [s]
+        uint32_t NumValues;
+        uint32_t Reserved;
+
+    }; // struct: FrameHeader
+
+    static_assert(sizeof(FrameHeader) == 32, "FBGStream::FrameHeader must be 32 bytes");
+
+    // "Peaks", "Forces_Tip" or "Forces_Sclera" (case insensitive); returns false for any other name
+    inline bool ParseStreamId(std::string name, StreamId& stream)
+    {
+        std::transform(
+            name.begin(),
+            name.end(),
+            name.begin(),
+            [] (unsigned char c) {return std::toupper(c);}
+        );
+
+        if (name == "PEAKS")
+            stream = STREAM_PEAKS;
+
+        else if (name == "FORCES_TIP")
+            stream = STREAM_FORCES_TIP;
+
+        else if (name == "FORCES_SCLERA")
+            stream = STREAM_FORCES_SCLERA;
+
+        else
+            return false;
+
+        return true;
+    }
+
+    inline size_t GetFrameSize(const size_t numValues) { return sizeof(FrameHeader) + numValues * sizeof(double); }
+
+    inline FrameHeader MakeFrameHeader(const StreamId stream, const uint64_t sequence, const double time, const size_t numValues)
+    {
+        FrameHeader header;
+        header.Magic     = MAGIC;
+        header.Version   = VERSION;
+        header.Stream    = stream;
+        header.Sequence  = sequence;
+        header.Time      = time;
+        header.NumValues = uint32_t(numValues);
+        header.Reserved  = 0;
+        return header;
+    }
+
+    // encodes a frame into an 8-byte aligned buffer; only allocates when the frame grows
+    inline void EncodeFrame(std::vector<double>& frame, const StreamId stream, const uint64_t sequence, const double time, const double* values, const size_t numValues)
+    {
+        frame.resize(GetFrameSize(numValues) / sizeof(double));
+
+        FrameHeader header = MakeFrameHeader(stream, sequence, time, numValues);
+        std::memcpy(frame.data(), &header, sizeof(header));
+        std::memcpy(frame.data() + sizeof(header) / sizeof(double), values, numValues * sizeof(double));
+    }
+
+    const uint32_t SUBSCRIPTION_MAGIC = 0x52474246; // "FBGR"
+    const size_t   MAX_SELECTIONS     = 32;
+
+    struct SubscriptionHeader
+    {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t NumSelections; // 0 subscribes to every value of every stream
+
+    }; // struct: SubscriptionHeader
+
+    struct Selection
+    {
+        uint16_t Stream;     // StreamId
+        uint16_t Decimation; // every Decimation-th frame of the stream is sent, as set by its first selection (0 and 1 send all)
+        uint32_t First;      // first value
+        uint32_t Count;      // values from First, 0 through the last one
+
+    }; // struct: Selection
+
+    static_assert(sizeof(SubscriptionHeader) == 8, "FBGStream::SubscriptionHeader must be 8 bytes");
+    static_assert(sizeof(Selection) == 12, "FBGStream::Selection must be 12 bytes");
+
+    inline size_t GetSubscriptionSize(const size_t numSelections) { return sizeof(SubscriptionHeader) + numSelections * sizeof(Selection); }
+
+    // returns false unless data holds a complete frame of this version
+    inline bool ParseFrameHeader(const uint8_t* data, const size_t size, FrameHeader& header)
+    {
+        if (size < sizeof(FrameHeader))
+            return false;
+
+        std::memcpy(&header, data, sizeof(FrameHeader));
+        return (
+            header.Magic == MAGIC
+            && header.Version == VERSION
+            && header.Stream < NUM_STREAMS
+            && size >= GetFrameSize(header.NumValues)
+        );
+    }
+
+    // returns false unless data holds a complete subscription request of this version
+    inline bool ParseSubscription(const uint8_t* data, const size_t size, SubscriptionHeader& header, std::vector<Selection>& selections)
+    {
+        if (size < sizeof(SubscriptionHeader))
+            return false;
+
+        std::memcpy(&header, data, sizeof(SubscriptionHeader));
+        if (
+            header.Magic != SUBSCRIPTION_MAGIC
+            || header.Version != VERSION
+            || header.NumSelections > MAX_SELECTIONS
+            || size < GetSubscriptionSize(header.NumSelections)
+        )
+            return false;
+
+        selections.resize(header.NumSelections);
+        std::memcpy(selections.data(), data + sizeof(SubscriptionHeader), header.NumSelections * sizeof(Selection));
+        for (const Selection& selection : selections)
+        {
+            if (selection.Stream >= NUM_STREAMS)
+                return false;
+        }
+
+        return true;
+    }
+
+} // namespace: FBGStream
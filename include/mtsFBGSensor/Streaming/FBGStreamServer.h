@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include <cisstCommon.h>
+
+#include "FBGStreamProtocol.h"
+
+/*
+ * Serves the FBG streams to local clients over a Unix domain (SOCK_SEQPACKET) socket.
+ *
+ * Producers Push() frames from their own thread (one thread per stream) into a preallocated
+ * queue per stream and return; the server thread sends every queued frame to every connected
+ * client, one message per frame. Client sockets are never waited on: a frame a client cannot
+ * take immediately is dropped for that client only, and a full queue drops the frame (and
+ * counts it) without ever blocking the producer.
+ *
+ * A client gets every stream until it sends a subscription request (see FBGStreamProtocol.h),
+ * which it may replace at any time. Its frames are gathered with sendmsg() straight from the
+ * queued frame: only the 32-byte header is built per client, the selected value ranges are
+ * sent from the shared slot.
+ *
+ * Configured from a "Local_Socket" JSON block:
+ *   {
+ *     "Socket_Path": "/tmp/fbg_sensor.sock",
+ *     "Queue_Size":  256,   // frames queued per stream
+ *     "Max_Clients": 16,
+ *     "Send_Buffer_Size": 65536 // bytes buffered per client socket (0 keeps the system default)
+ *   }
+ */
+class CISST_EXPORT FBGStreamServer
+{
+public:
+    FBGStreamServer() = default;
+    ~FBGStreamServer();
+
+    FBGStreamServer(const FBGStreamServer&)            = delete;
+    FBGStreamServer& operator=(const FBGStreamServer&) = delete;
+
+    void Configure(const Json::Value& jsonConfig);
+
+    // binds the socket and starts the server thread; throws std::runtime_error
+    void Start();
+    void Stop();
+
+    inline bool               IsRunning()     const { return m_IsRunning; }
+    inline const std::string& GetSocketPath() const { return m_SocketPath; }
+
+    // queue a frame; returns false if it was dropped
+    bool Push(const FBGStream::StreamId stream, const double time, const double* values, const size_t numValues);
+
+    inline size_t GetNumberOfClients()       const { return m_NumClients; }
+    inline size_t GetNumberOfSentFrames()    const { return m_NumSent; }
+    inline size_t GetNumberOfDroppedFrames() const { return m_NumDropped; } // queue overruns
+    inline size_t GetNumberOfSkippedFrames() const { return m_NumSkipped; } // frames a client could not take
+
+protected:
+    // single producer / single consumer queue of encoded frames
+    struct Stream
+    {
+        std::vector<std::vector<double>> Slots; // FrameHeader followed by the values, 8-byte aligned
+        std::atomic<size_t>              Head{0}; // next slot written by Push
+        std::atomic<size_t>              Tail{0}; // next slot sent
+        uint64_t                         Sequence = 0;
+    };
+
+    struct Client
+    {
+        int    Socket     = -1;
+        size_t NumSkipped = 0;
+
+        // subscription, every value of every stream until the client sends one
+        bool                              IsFiltered = false;
+        std::vector<FBGStream::Selection> Selections;
+        uint16_t                          Decimation[FBGStream::NUM_STREAMS];
+        bool                              IsSubscribed[FBGStream::NUM_STREAMS];
+        uint64_t                          NumFrames[FBGStream::NUM_STREAMS]; // frames of each stream since subscribing
+
+        FBGStream::FrameHeader Header;     // of the frame being sent
+        std::vector<iovec>     IOVectors;  // header and value ranges of the frame being sent
+    };
+
+    void ServerLoop();
+    void AcceptClients();
+    void ReceiveSubscription(Client& client);
+    void SendFrames(const FBGStream::StreamId streamId);
+    bool GatherFrame(Client& client, const std::vector<double>& slot);
+    void CloseClient(Client& client);
+
+    // configuration
+    std::string m_SocketPath = "/tmp/fbg_sensor.sock";
+    size_t      m_QueueSize  = 256;
+    size_t      m_MaxClients = 16;
+    int         m_SendBufferSize = 0;
+
+    Stream              m_Streams[FBGStream::NUM_STREAMS];
+    std::vector<Client>  m_Clients;       // server thread only
+    std::vector<uint8_t> m_RequestBuffer; // server thread only
+
+    int               m_ListenSocket = -1;
+    int               m_WakeEvent    = -1; // eventfd signalled by Push
+    std::atomic<bool> m_IsRunning{false};
+    std::atomic<bool> m_Stop{false};
+    std::thread       m_Server;
+
+    std::atomic<size_t> m_NumClients{0};
+    std::atomic<size_t> m_NumSent{0};
+    std::atomic<size_t> m_NumDropped{0};
+    std::atomic<size_t> m_NumSkipped{0};
+
+}; // class: FBGStreamServer
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Multiset of values kept in order, with O(log n) expected insertion, removal and selection of
+ * the k-th smallest value (a treap whose nodes count their subtree).
+ *
+ * The nodes come from a pool sized by Reserve(), so nothing is allocated while the set holds
+ * at most that many values (e.g. the samples of a sliding window).
+ */
+template <typename T>
+class OrderStatisticTreap
+{
+public:
+    void Reserve(const size_t capacity)
+    {
+        m_Nodes.resize(capacity);
+        Clear();
+    }
+
+    void Clear()
+    {
+        m_Root = NONE;
+        m_Free.clear();
+        m_Free.reserve(m_Nodes.size());
+        for (size_t i = m_Nodes.size(); i > 0; i--)
+            m_Free.push_back(int32_t(i - 1));
+    }
+
+    inline size_t Size()     const { return m_Root == NONE ? 0 : m_Nodes[m_Root].Size; }
+    inline size_t Capacity() const { return m_Nodes.size(); }
+
+    // returns false when the pool is full
+    bool Insert(const T& value)
+    {
+        if (m_Free.empty())
+            return false;
+
+        int32_t node = m_Free.back();
+        m_Free.pop_back();
+        m_Nodes[node].Value    = value;
+        m_Nodes[node].Priority = NextPriority();
+        m_Nodes[node].Size     = 1;
+        m_Nodes[node].Left     = NONE;
+        m_Nodes[node].Right    = NONE;
+
+        int32_t less, notLess;
+        Split(m_Root, value, less, notLess);
+        m_Root = Merge(Merge(less, node), notLess);
+        return true;
+    }
+
+    // removes one instance of the value; returns false if there is none
+    bool Erase(const T& value)
+    {
+        // path to the node, then the node replaced by its merged children
+        int32_t* link = &m_Root;
+        while (*link != NONE && !(m_Nodes[*link].Value == value))
+            link = value < m_Nodes[*link].Value ? &m_Nodes[*link].Left : &m_Nodes[*link].Right;
+
+        if (*link == NONE)
+            return false;
+
+        int32_t node = *link;
+        *link = Merge(m_Nodes[node].Left, m_Nodes[node].Right);
+        m_Free.push_back(node);
+
+        // the subtrees on the path lost one value
+        for (int32_t parent = m_Root; parent != *link; )
+        {
+            m_Nodes[parent].Size--;
+            parent = value < m_Nodes[parent].Value ? m_Nodes[parent].Left : m_Nodes[parent].Right;
+        }
+        return true;
+    }
+
+    // k-th smallest value, k < Size()
+    const T& Select(size_t k) const
+    {
+        int32_t node = m_Root;
+        while (true)
+        {
+            size_t leftSize = SizeOf(m_Nodes[node].Left);
+            if (k < leftSize)
+                node = m_Nodes[node].Left;
+
+            else if (k == leftSize)
+                return m_Nodes[node].Value;
+
+            else
+            {
+                k   -= leftSize + 1;
+                node = m_Nodes[node].Right;
+            }
+        }
+    }
+
+private:
+    static const int32_t NONE = -1;
+
+    struct Node
+    {
+        T        Value;
+        uint32_t Priority;
+        uint32_t Size;
+        int32_t  Left;
+        int32_t  Right;
+    };
+
+    inline uint32_t SizeOf(const int32_t node) const { return node == NONE ? 0 : m_Nodes[node].Size; }
+
+    inline void UpdateSize(const int32_t node)
+    {
+        m_Nodes[node].Size = 1 + SizeOf(m_Nodes[node].Left) + SizeOf(m_Nodes[node].Right);
+    }
+
+    inline uint32_t NextPriority()
+    {
+        // xorshift32
+        m_Seed ^= m_Seed << 13;
+        m_Seed ^= m_Seed >> 17;
+        m_Seed ^= m_Seed << 5;
+        return m_Seed;
+    }
+
+    // values less than the key to one tree, the others to the second
+    void Split(const int32_t node, const T& key, int32_t& less, int32_t& notLess)
+    {
+        if (node == NONE)
+        {
+            less    = NONE;
+            notLess = NONE;
+            return;
+        }
+
+        if (m_Nodes[node].Value < key)
+        {
+            Split(m_Nodes[node].Right, key, m_Nodes[node].Right, notLess);
+            less = node;
+        }
+        else
+        {
+            Split(m_Nodes[node].Left, key, less, m_Nodes[node].Left);
+            notLess = node;
+        }
+        UpdateSize(node);
+    }
+
+    // every value of the first tree is before every value of the second
+    int32_t Merge(const int32_t first, const int32_t second)
+    {
+        if (first == NONE)
+            return second;
+
+        if (second == NONE)
+            return first;
+
+        if (m_Nodes[first].Priority > m_Nodes[second].Priority)
+        {
+            m_Nodes[first].Right = Merge(m_Nodes[first].Right, second);
+            UpdateSize(first);
+            return first;
+        }
+
+        m_Nodes[second].Left = Merge(first, m_Nodes[second].Left);
+        UpdateSize(second);
+        return second;
+    }
+
+    std::vector<Node>    m_Nodes;
+    std::vector<int32_t> m_Free;
+    int32_t              m_Root = NONE;
+    uint32_t             m_Seed = 2463534242u;
+
+}; // class: OrderStatisticTreap
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cisstCommon.h>
+
+/*
+ * Scheduling, CPU affinity and memory settings of a latency-critical thread.
+ *
+ * Configured from a "Real_Time" JSON block:
+ *   {
+ *     "Policy":        "FIFO",     // "FIFO", "RR" or "OTHER"
+ *     "Priority":      80,         // 1-99 for FIFO/RR
+ *     "CPU_Affinity":  [2, 3],     // CPUs the thread may run on (empty keeps the inherited mask)
+ *     "Lock_Memory":   true,       // mlockall the whole process and keep freed heap mapped
+ *     "Prefault_Stack": 262144,    // bytes of stack touched up front
+ *     "Prefault_Heap":  8388608    // bytes of heap touched up front (with "Lock_Memory")
+ *   }
+ *
+ * Apply() must run on the thread itself (e.g. in a task's Startup). Every step is attempted
+ * and reported; a step that fails (typically EPERM without CAP_SYS_NICE / a memlock limit)
+ * leaves the others in place.
+ */
+class CISST_EXPORT RealTimeSettings
+{
+public:
+    void Configure(const Json::Value& jsonConfig);
+
+    inline bool IsConfigured() const { return m_IsConfigured; }
+
+    // applies the settings to the calling thread and describes what was applied in report;
+    // returns false if any step failed
+    bool Apply(const std::string& threadName, std::string& report) const;
+
+protected:
+    bool             m_IsConfigured  = false;
+    std::string      m_Policy        = "OTHER";
+    int              m_Priority      = 0;
+    std::vector<int> m_CPUAffinity;
+    bool             m_LockMemory    = false;
+    size_t           m_PrefaultStack = 0; // [bytes]
+    size_t           m_PrefaultHeap  = 0; // [bytes]
+
+}; // class: RealTimeSettings
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+ * One SIMD register of doubles (AVX2, aarch64 NEON or a plain double), for loops over
+ * structure-of-arrays rows padded to a multiple of PADDING values. Selected at compile time,
+ * as the spectrum calibration is (see mtsFBGSensor_NATIVE_ARCH).
+ */
+namespace SIMDLane
+{
+    // rows padded to this many values hold a whole number of lanes of every width
+    const size_t PADDING = 4;
+
+#if defined(__AVX2__)
+    const size_t WIDTH = 4;
+    typedef __m256d Lane;
+
+    inline Lane Load(const double* values)      { return _mm256_loadu_pd(values); }
+    inline void Store(double* values, Lane lane) { _mm256_storeu_pd(values, lane); }
+    inline Lane Set(const double value)         { return _mm256_set1_pd(value); }
+    inline Lane Add(Lane a, Lane b)             { return _mm256_add_pd(a, b); }
+    inline Lane Sub(Lane a, Lane b)             { return _mm256_sub_pd(a, b); }
+    inline Lane Mul(Lane a, Lane b)             { return _mm256_mul_pd(a, b); }
+#if defined(__FMA__)
+    inline Lane MulAdd(Lane a, Lane b, Lane c)  { return _mm256_fmadd_pd(a, b, c); }
+#else
+    inline Lane MulAdd(Lane a, Lane b, Lane c)  { return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const size_t WIDTH = 2;
+    typedef float64x2_t Lane;
+
+    inline Lane Load(const double* values)      { return vld1q_f64(values); }
+    inline void Store(double* values, Lane lane) { vst1q_f64(values, lane); }
+    inline Lane Set(const double value)         { return vdupq_n_f64(value); }
+    inline Lane Add(Lane a, Lane b)             { return vaddq_f64(a, b); }
+    inline Lane Sub(Lane a, Lane b)             { return vsubq_f64(a, b); }
+    inline Lane Mul(Lane a, Lane b)             { return vmulq_f64(a, b); }
+    inline Lane MulAdd(Lane a, Lane b, Lane c)  { return vfmaq_f64(c, a, b); }
+#else
+    const size_t WIDTH = 1;
+    typedef double Lane;
+
+    inline Lane Load(const double* values)      { return *values; }
+    inline void Store(double* values, Lane lane) { *values = lane; }
+    inline Lane Set(const double value)         { return value; }
+    inline Lane Add(Lane a, Lane b)             { return a + b; }
+    inline Lane Sub(Lane a, Lane b)             { return a - b; }
+    inline Lane Mul(Lane a, Lane b)             { return a * b; }
+    inline Lane MulAdd(Lane a, Lane b, Lane c)  { return a * b + c; }
+#endif
+
+    // values rounded up to whole rows
+    inline size_t PaddedSize(const size_t size) { return ((size + PADDING - 1) / PADDING) * PADDING; }
+
+} // namespace SIMDLane
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TripleBuffer.h"
+
+/*
+ * In-process consumers of the values a task produces, called on the producing thread.
+ *
+ * Notify() walks an immutable snapshot of the subscribers, so adding or removing one from
+ * another thread never blocks the producer; a subscriber being removed may still receive the
+ * value being notified. Callbacks run in the producer's loop: they must be short, must not
+ * block and must not throw. A TripleBuffer subscriber hands the latest value to one thread
+ * that polls it (e.g. a control loop) without any callback of its own.
+ */
+template <typename T>
+class SubscriberList
+{
+public:
+    typedef std::function<void(const T&)> Callback;
+
+    // returns the subscriber's id for Remove()
+    size_t Add(const Callback& callback)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        std::shared_ptr<Subscribers> subscribers = std::make_shared<Subscribers>(*std::atomic_load(&m_Subscribers));
+        subscribers->push_back({++m_LastId, callback});
+
+        std::atomic_store(&m_Subscribers, std::shared_ptr<const Subscribers>(subscribers));
+        m_HasSubscribers.store(true, std::memory_order_release);
+        return m_LastId;
+    }
+
+    // the buffer is written by the producer only, so it may have a single reading thread
+    size_t Add(const std::shared_ptr<TripleBuffer<T>>& buffer)
+    {
+        return Add([buffer] (const T& value) { buffer->Write(value); });
+    }
+
+    bool Remove(const size_t id)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        std::shared_ptr<Subscribers> subscribers = std::make_shared<Subscribers>(*std::atomic_load(&m_Subscribers));
+        size_t numSubscribers = subscribers->size();
+        for (auto it = subscribers->begin(); it != subscribers->end(); it++)
+        {
+            if (it->Id == id)
+            {
+                subscribers->erase(it);
+                break;
+            }
+        }
+        if (subscribers->size() == numSubscribers)
+            return false;
+
+        m_HasSubscribers.store(!subscribers->empty(), std::memory_order_release);
+        std::atomic_store(&m_Subscribers, std::shared_ptr<const Subscribers>(subscribers));
+        return true;
+    }
+
+    inline bool IsEmpty() const { return !m_HasSubscribers.load(std::memory_order_acquire); }
+
+    void Notify(const T& value) const
+    {
+        // the common case of no in-process consumers costs one load
+        if (IsEmpty())
+            return;
+
+        std::shared_ptr<const Subscribers> subscribers = std::atomic_load(&m_Subscribers);
+        for (const Subscriber& subscriber : *subscribers)
+            subscriber.Notify(value);
+    }
+
+private:
+    struct Subscriber
+    {
+        size_t   Id;
+        Callback Notify;
+    };
+    typedef std::vector<Subscriber> Subscribers;
+
+    std::shared_ptr<const Subscribers> m_Subscribers = std::make_shared<const Subscribers>();
+    std::atomic<bool>                  m_HasSubscribers{false};
+    std::mutex                         m_Mutex; // serializes Add() and Remove()
+    size_t                             m_LastId = 0;
+
+}; // class: SubscriberList
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Wait-free latest-value hand-off between one writing and one reading thread.
+ *
+ * The writer fills the back slot and swaps it with the middle one; the reader swaps the middle
+ * slot with its front one when a newer value was published. Neither side ever waits or sees a
+ * partially written value, and values the reader did not pick up in time are overwritten.
+ *
+ * Slots are only assigned after construction, so types that own memory (e.g. vctDoubleVec)
+ * do not allocate once they have been written at their final size.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    explicit TripleBuffer(const T& initial)
+    {
+        for (T& slot : m_Slots)
+            slot = initial;
+    }
+
+    TripleBuffer(const TripleBuffer&)            = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side: fill GetWriteBuffer() then Publish(), or Write() a copy
+    inline T& GetWriteBuffer() { return m_Slots[m_Back]; }
+
+    inline void Publish()
+    {
+        uint8_t previous = m_Middle.exchange(m_Back | DIRTY, std::memory_order_acq_rel);
+        m_Back = previous & INDEX;
+    }
+
+    inline void Write(const T& value)
+    {
+        GetWriteBuffer() = value;
+        Publish();
+    }
+
+    // Reader side: Update() takes the latest published value, if any, into GetReadBuffer()
+    inline bool Update()
+    {
+        if (!(m_Middle.load(std::memory_order_relaxed) & DIRTY))
+            return false;
+
+        uint8_t previous = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+        m_Front = previous & INDEX;
+        return true;
+    }
+
+    inline const T& GetReadBuffer() const { return m_Slots[m_Front]; }
+
+    // copies the latest value; returns false if it was already read
+    inline bool Read(T& value)
+    {
+        bool isNew = Update();
+        value = m_Slots[m_Front];
+        return isNew;
+    }
+
+    inline bool HasNewValue() const { return m_Middle.load(std::memory_order_relaxed) & DIRTY; }
+
+private:
+    static const uint8_t INDEX = 0x3;
+    static const uint8_t DIRTY = 0x4;
+
+    T m_Slots[3];
+
+    // the writer's and reader's indices each stay in their own thread's cache line
+    alignas(64) std::atomic<uint8_t> m_Middle{1};
+    alignas(64) uint8_t              m_Back  = 2;
+    alignas(64) uint8_t              m_Front = 0;
+
+}; // class: TripleBuffer
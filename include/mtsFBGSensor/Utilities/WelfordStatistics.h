@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <cisstVector.h>
+
+/*
+ * Running mean and variance of every element of a vector signal (Welford's algorithm), stable
+ * for small variations on a large offset such as peak wavelengths. Missing values (NaN) are
+ * skipped, so every element keeps its own count.
+ */
+class WelfordStatistics
+{
+public:
+    void Reset(const size_t numChannels)
+    {
+        m_Counts.assign(numChannels, 0);
+        m_Means.assign(numChannels, 0.0);
+        m_SumSquares.assign(numChannels, 0.0);
+    }
+
+    // elements beyond the configured channels are ignored
+    void Add(const vctDoubleVec& sample)
+    {
+        size_t numChannels = std::min<size_t>(sample.size(), m_Counts.size());
+        for (size_t i = 0; i < numChannels; i++)
+        {
+            double value = sample[i];
+            if (std::isnan(value))
+                continue;
+
+            m_Counts[i]++;
+            double delta    = value - m_Means[i];
+            m_Means[i]     += delta / double(m_Counts[i]);
+            m_SumSquares[i] += delta * (value - m_Means[i]);
+        }
+    }
+
+    inline size_t GetNumberOfChannels()    const { return m_Counts.size(); }
+    inline size_t GetCount(const size_t i) const { return m_Counts[i]; }
+    inline double GetMean(const size_t i)  const { return m_Counts[i] > 0 ? m_Means[i] : std::numeric_limits<double>::quiet_NaN(); }
+
+    // sample variance (n - 1)
+    inline double GetVariance(const size_t i) const
+    {
+        return m_Counts[i] > 1 ? m_SumSquares[i] / double(m_Counts[i] - 1) : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    inline double GetStandardDeviation(const size_t i) const { return std::sqrt(GetVariance(i)); }
+
+private:
+    std::vector<size_t> m_Counts;
+    std::vector<double> m_Means;
+    std::vector<double> m_SumSquares;
+
+}; // class: WelfordStatistics
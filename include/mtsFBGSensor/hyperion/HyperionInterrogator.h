@@ -1,20 +1,34 @@
 #ifndef _HYPERION_INTERROGATOR_H
 #define _HYPERION_INTERROGATOR_H
 
+#include <chrono>
+#include <limits>
+#include <memory>
+
 #include <cisstCommon.h>
 
 #include "hLibrary.h"
 
 #include "mtsFBGSensor/mtsFBGSensor/Interrogator.h"
+#include "mtsFBGSensor/SpectrumProcessing/SpectrumPeakDetector.h"
+#include "mtsFBGSensor/SpectrumProcessing/SpectrumRecorder.h"
 
 class HyperionInterrogator : public Interrogator
 {
     public:
         static const unsigned int DEFAULT_PORT = H_CMD_PORT;
 
+        // How queued peak samples are collapsed when catching up on the stream
+        enum class DrainMode {
+            NEWEST,
+            AVERAGE,
+        }; // enum: DrainMode
+
         HyperionInterrogator(const std::string& ipAddress, const unsigned int port = DEFAULT_PORT);
         ~HyperionInterrogator();
 
+        void Configure(const Json::Value& jsonConfig) override;
+
         // Abstract base class methods
         int GetNumberOfChannels() const override;
 
@@ -24,16 +38,76 @@ class HyperionInterrogator : public Interrogator
         bool StreamPeaks() override;
         bool DisableStreamPeaks() override;
 
+        // Streaming rate control
+        int  GetStreamingDivider() const override { return m_StreamingRate.Divider; }
+        bool SetStreamingDivider(const int divider) override;
+
+        // Streaming telemetry
+        double GetStreamingRate()            const override { return m_StreamingRate.Rate; }
+        size_t GetNumberOfQueuedFrames()     const override;
+        int    GetStreamingBufferAvailable() const override { return m_BufferMonitor.Available; }
+        size_t GetNumberOfCollapsedFrames()  const override { return m_BufferMonitor.NumCollapsed; }
+
         // Methods to get the peaks from a channel
-        vctDoubleVec GetPeaks() const  override;
+        std::vector<vctDoubleVec> GetChannelPeaks() const override;
+        std::vector<vctDoubleMat> GetChannelPeakQuality() const override { return m_ChannelPeakQuality; }
+        double                    GetPeaksTimestamp()     const override { return m_PeaksTimestamp; }
+        int64_t                   GetPeaksSerialNumber()  const override { return m_PeaksSerialNumber; }
         vctDoubleVec GetPeaks(const size_t channelId) const override;
 
     private: 
         Hyperion* m_Hyperion = nullptr;
 
+        // instrument time of the last frame returned by GetChannelPeaks [s]
+        mutable double  m_PeaksTimestamp    = std::numeric_limits<double>::quiet_NaN();
+        mutable int64_t m_PeaksSerialNumber = -1;
+
+        // Software peak detection on streamed spectra (null when the instrument's peaks are used)
+        std::unique_ptr<SpectrumPeakDetector> m_SpectrumPeakDetector;
+        mutable std::vector<vctDoubleMat>     m_ChannelPeakQuality;
+
+        // Raw spectrum capture to disk (null when not configured)
+        std::unique_ptr<SpectrumRecorder> m_SpectrumRecorder;
+
+        // Laser scan speed and streaming divider selection
+        struct {
+            double TargetRate    = 0.0; // requested output rate in Hz (0 keeps the instrument's scan speed)
+            double LatencyBudget = 0.0; // maximum time between output samples in seconds (0 for no limit)
+            int    ScanSpeed     = 0;   // selected laser scan speed in Hz
+            int    Divider       = 1;   // selected peak streaming divider
+            double Rate          = 0.0; // achieved output rate in Hz
+        } m_StreamingRate;
+
+        // Backpressure monitoring of the instrument's peak streaming buffer
+        mutable struct {
+            double    SamplePeriod     = 0.5; // seconds between buffer level samples
+            int       DrainThreshold   = 50;  // enter drain mode below this available percentage
+            int       RecoverThreshold = 90;  // leave drain mode at or above this available percentage
+            DrainMode Mode             = DrainMode::NEWEST;
+
+            int       Available    = 100;
+            bool      IsDraining   = false;
+            size_t    NumCollapsed = 1;
+            std::chrono::steady_clock::time_point LastSampleTime;
+        } m_BufferMonitor;
+
         hACQPeaks GetPeaksInterrogator() const;
+        static std::vector<vctDoubleVec> SplitChannelPeaks(hACQPeaks& peaksMsg);
+
+        void SelectStreamingRate();
+
+        const std::vector<SpectrumPeak>& DetectSpectrumPeaks() const;
+
+        // spectra are streamed for peak detection, recording or both
+        inline bool IsStreamingSpectrum() const { return m_SpectrumPeakDetector || m_SpectrumRecorder; }
+
+        void RecordSpectrum(const hSpectrumFrame& frame) const;
+        void RecordQueuedSpectra() const;
+
+        void         SampleStreamingBuffer() const;
+        std::vector<vctDoubleVec> DrainStreamedPeaks() const;
 
 
 }; // class; HyperionInterrogator
 
-#endif
\ No newline at end of file
+#endif
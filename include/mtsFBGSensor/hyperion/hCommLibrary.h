@@ -29,6 +29,9 @@ void sleep(double seconds);
 #define     H_SPECTRUM_STREAM_PORT 51973
 #define     H_DEFAULT_TIMEOUT   10000
 
+#define     H_READ_BUFFER_SIZE  262144
+#define     H_READ_CHUNK_SIZE   65536
+
 #define     H_SUCCESS 0
 
 
@@ -113,7 +116,21 @@ protected:
     std::string lastErrorMsg;
     
     /*!
-     Read raw data back from a communication channel (virtual).
+     Receive buffer.  Bytes in [readStart, readEnd) have been received but not yet parsed.
+     */
+    std::vector<uint8_t> readBuffer;
+    size_t readStart;
+    size_t readEnd;
+    
+    /*!
+     Reusable storage for the content of the last response.  lastResponse.content points into this buffer
+     and remains valid until the next call to read_response().
+     */
+    std::vector<uint8_t> responseContent;
+    
+    /*!
+     Read raw data back from a communication channel (virtual).  Data is served from the receive buffer,
+     which is refilled with as many bytes as are available per system call.
      
      @param numBytes the number of Bytes to be returned.
      
@@ -122,7 +139,33 @@ protected:
      @return returns the number of bytes read, or -1 if there is an error
      
      */
-    virtual int read_data(uint32_t numBytes, uint8_t data[]) = 0;
+    virtual int read_data(uint32_t numBytes, uint8_t data[]);
+    
+    /*!
+     Perform a single receive on the communication channel (virtual).
+     
+     @param data Buffer that receives the data.
+     
+     @param maxBytes The maximum number of bytes to be received.
+     
+     @param wait If true, block until at least one byte is available.  Otherwise return immediately.
+     
+     @return Returns the number of bytes received (0 if wait is false and no data is pending),
+     or -1 if there is an error or the connection was closed.
+     */
+    virtual ssize_t receive_data(uint8_t* data, size_t maxBytes, bool wait) = 0;
+    
+    /*!
+     Make room for at least numBytes of unparsed data in the receive buffer, compacting it and
+     growing it as required.
+     */
+    void reserve_read_buffer(size_t numBytes);
+    
+    /*!
+     Block until at least numBytes of unparsed data are in the receive buffer.  Each system call reads
+     as much data as is available, so frames that have backed up are pulled in together.  Throws HyperionException on error.
+     */
+    void fill_read_buffer(size_t numBytes);
     
     /*!
      Write raw data to a communication channel (virtual)
@@ -141,6 +184,12 @@ protected:
     
 public:
     
+    /*!
+     Constructor for hComm class
+     */
+    
+    hComm() : readBuffer(H_READ_BUFFER_SIZE), readStart(0), readEnd(0) {}
+    
     /*!
      Destructor for hComm class (virtual)
      */
@@ -188,6 +237,24 @@ public:
     
     const hResponse read_response();
     
+    /*!
+     Pull any data that is already pending on the communication channel into the receive buffer without blocking.
+     Throws HyperionException on error.
+     
+     @return The number of bytes received.
+     */
+    
+    int poll_responses();
+    
+    /*!
+     Count the complete responses held in the receive buffer.  Each of these can be returned by read_response()
+     without another system call.
+     
+     @return The number of complete responses that are buffered.
+     */
+    
+    int get_num_buffered_responses() const;
+    
     virtual int get_last_error(std::string &errorMsg) = 0;
     
     
@@ -231,24 +298,25 @@ public:
 class hCommTCPSocket:public hComm
 {
 private:
-    uint8_t* readBuffer;
     std::string ipAddress;
     int port;
     int sockfd;
     bool persistent;
     
     /*!
-     Read raw data back from a communication channel.
+     Perform a single recv() on the socket.
      
-     @param numBytes the number of Bytes to be returned.
+     @param data Buffer that receives the data.
      
-     @param data the data returned as an array of bytes.
+     @param maxBytes The maximum number of bytes to be received.
      
-     @return returns the number of bytes read, or -1 if there is an error
+     @param wait If true, block until data is available.  Otherwise return immediately.
+     
+     @return returns the number of bytes received, or -1 if there is an error
      
      */
     
-    int read_data(uint32_t numBytes, uint8_t data[]);
+    ssize_t receive_data(uint8_t* data, size_t maxBytes, bool wait);
     
     /*!
      Write raw data to a communication channel
@@ -13,8 +13,14 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstdlib>
+#include <new>
 #include <time.h>
 
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
 #include "hCommLibrary.h"
 
 #define H_LIB_VERSION "0.9.5.0"
@@ -249,6 +255,116 @@ struct hACQSpectrum
     
 };
 
+/*!
+ Output formats requested from Hyperion.read_spectrum_frame().  These can be combined.
+ */
+
+enum hSpectrumOutput
+{
+    H_SPECTRUM_RAW = 0,
+    H_SPECTRUM_DOUBLE = 1,
+    H_SPECTRUM_FLOAT = 2
+};
+
+/*!
+ Spectrum data returned with each call to Hyperion.read_spectrum_frame().  The data pointers refer to buffers
+ owned by the Hyperion object that are reused for every spectrum, and remain valid until the next spectrum is read.
+ 
+ @field spectrumHeader The hACQSpectrumHeader structure for this spectrum.
+ 
+ @field rawSpectrumData The raw spectrum data, numChannels blocks of numPoints samples, as received from the instrument.
+ 
+ @field numCalibratedChannels The channels in the calibrated data, the first numCalibratedChannels of the header's.  Fewer
+ than numChannels if the instrument reported calibrations for fewer channels.
+ 
+ @field calibratedSpectrumData The calibrated spectrum data in dBm, or nullptr if H_SPECTRUM_DOUBLE was not requested.
+ 
+ @field calibratedSpectrumDataFloat The calibrated spectrum data in dBm as float, or nullptr if H_SPECTRUM_FLOAT was not requested.
+ */
+
+struct hSpectrumFrame
+{
+    hACQSpectrumHeader spectrumHeader;
+    const uint16_t* rawSpectrumData;
+    size_t numCalibratedChannels;
+    const double* calibratedSpectrumData;
+    const float* calibratedSpectrumDataFloat;
+};
+
+/*!
+ Storage aligned for SIMD loads and stores that only grows, so that it can be reused from one acquisition to the next.
+ */
+
+template <typename T>
+class hAlignedBuffer
+{
+private:
+    T* data;
+    size_t capacity;
+    size_t count;
+    
+    void release()
+    {
+#ifdef _WIN32
+        _aligned_free(data);
+#else
+        free(data);
+#endif
+        data = nullptr;
+        capacity = 0;
+    }
+    
+public:
+    static const size_t alignment = 64;
+    
+    hAlignedBuffer() : data(nullptr), capacity(0), count(0) {}
+    hAlignedBuffer(const hAlignedBuffer&) = delete;
+    hAlignedBuffer& operator=(const hAlignedBuffer&) = delete;
+    ~hAlignedBuffer()
+    {
+        release();
+    }
+    
+    /*!
+     Sets the number of elements, reallocating only if the buffer has to grow.  The contents are not preserved when reallocating.
+     */
+    void resize(size_t numElements)
+    {
+        if (numElements > capacity)
+        {
+            release();
+#ifdef _WIN32
+            data = (T*)_aligned_malloc(numElements*sizeof(T), alignment);
+#else
+            void* memory = nullptr;
+            data = posix_memalign(&memory, alignment, numElements*sizeof(T)) == 0 ? (T*)memory : nullptr;
+#endif
+            if (data == nullptr)
+            {
+                count = 0;
+                throw std::bad_alloc();
+            }
+            capacity = numElements;
+        }
+        count = numElements;
+    }
+    
+    T* get()
+    {
+        return data;
+    }
+    
+    const T* get() const
+    {
+        return data;
+    }
+    
+    size_t size() const
+    {
+        return count;
+    }
+};
+
 
 
 /*!
@@ -268,7 +384,13 @@ private:
     int spectrumChannel;
     hResponse lastResponse;
     uint8_t* peakContent;
-    uint8_t* spectrumContent;
+    hAlignedBuffer<uint8_t> spectrumContent;
+    
+    hSpectrumFrame spectrumFrame;
+    hAlignedBuffer<double> calibratedSpectrum;
+    hAlignedBuffer<float> calibratedSpectrumFloat;
+    
+    void copy_spectrum_content();
     
     void init();
     
@@ -412,6 +534,38 @@ public:
     
     const hACQSpectrum get_raw_spectrum(int channel);
     
+    /*!
+     Acquires a full spectrum into reusable buffers, without allocating per spectrum.  The spectrum is streamed if
+     spectrum streaming is enabled, and requested from the instrument otherwise.  The raw data are referenced in the
+     comm's response buffer (which read_response() copies the payload into), and calibrated into reusable aligned
+     buffers.
+     
+     @param outputs Combination of hSpectrumOutput flags selecting the calibrated outputs to compute.
+     
+     @return Returns an hSpectrumFrame whose data remain valid until the next spectrum is acquired.
+     */
+    
+    const hSpectrumFrame& read_spectrum_frame(int outputs = H_SPECTRUM_DOUBLE);
+    
+    /*!
+     Converts raw spectrum samples to dBm power as raw*invScale + offset.  Vectorized with AVX2 or NEON when the
+     compiler targets them.
+     
+     @param rawSpectrum Raw samples to convert.
+     
+     @param numSamples Number of samples.
+     
+     @param invScale Inverse of the channel's calibration scale.
+     
+     @param offset The channel's calibration offset.
+     
+     @param calibratedSpectrum Output buffer of numSamples elements.
+     */
+    
+    static void calibrate_spectrum(const uint16_t* rawSpectrum, size_t numSamples, double invScale, double offset, double* calibratedSpectrum);
+    
+    static void calibrate_spectrum(const uint16_t* rawSpectrum, size_t numSamples, float invScale, float offset, float* calibratedSpectrum);
+    
     
     /*!
      Sets the value of the peak streaming divider, which determines the rate at which streaming peak data is returned. if peakStreamingDivider = 5, then every 5th sample is streamed out on the peak streaming port.
@@ -443,6 +597,16 @@ public:
      */
     
     const hACQPeaks stream_peaks();
+    
+    /*!
+     Pulls all pending data from the peak streaming port without blocking and counts the complete peak samples
+     that have been received.  Each of them can be returned by stream_peaks() without another read on the socket.
+     
+     @return Returns the number of peak samples that are queued on the client.
+     
+     */
+    
+    int get_num_queued_peaks();
     /*!
      Disables streaming of peak data
      
@@ -495,6 +659,17 @@ public:
     
     const hACQSpectrum stream_spectrum();
     
+    /*!
+     Pulls all pending data from the spectrum streaming port without blocking and counts the complete spectra
+     that have been received.  Each of them can be returned by stream_spectrum() or read_spectrum_frame()
+     without another read on the socket.
+     
+     @return Returns the number of spectra that are queued on the client.
+     
+     */
+    
+    int get_num_queued_spectra();
+    
     /*!
      Disables streaming of spectrum data
      
@@ -0,0 +1,77 @@
+#ifndef _CLOCKSYNCHRONIZER_H
+#define _CLOCKSYNCHRONIZER_H
+
+#include <deque>
+#include <vector>
+
+#include <cisstCommon.h>
+
+/*
+ * Maps instrument timestamps onto the host clock from the receive times of the frames.
+ *
+ * A frame received at host time h and stamped t by the instrument satisfies
+ *   h - t = offset + skew * (t - t0) + delay,   delay >= 0
+ * so the lower envelope of (h - t) over t is the clock model and everything above it is
+ * transport and queueing delay. The window is split into segments of equal instrument time;
+ * the line is fitted through the minimum of each closed segment with a Theil-Sen estimator
+ * (median of the pairwise slopes), which ignores segments that were congested throughout.
+ *
+ * One-way timestamps cannot tell a constant transport delay from a clock offset: the envelope
+ * includes the smallest delay seen, which "Fixed_Delay" removes when it is known.
+ */
+class CISST_EXPORT ClockSynchronizer
+{
+public:
+    // configure from the "Clock_Synchronization" JSON block
+    void Configure(const Json::Value& jsonConfig);
+
+    inline bool IsEnabled()      const { return m_Enabled; }
+    inline bool IsSynchronized() const { return m_IsSynchronized; }
+
+    // add one frame's instrument time and host receive time [s]
+    void AddSample(const double instrumentTime, const double hostTime);
+    void Reset();
+
+    // host time at which the instrument stamped instrumentTime [s]
+    double ToHostTime(const double instrumentTime) const;
+
+    // clock model at the last sample
+    inline double GetOffset()       const { return m_LastOffset; }  // host - instrument time [s]
+    inline double GetSkew()         const { return m_Skew; }        // drift of the host clock relative to the instrument's [s/s]
+    inline double GetNetworkDelay() const { return m_Delay; }       // mean receive delay after acquisition [s]
+
+protected:
+    struct Segment
+    {
+        double Start;      // instrument time of the first sample, relative to the reference [s]
+        double MinTime;    // relative instrument time of the sample with the smallest difference [s]
+        double MinOffset;  // smallest host - instrument time [s]
+    };
+
+    void Fit();
+
+    // configuration
+    bool   m_Enabled       = true;
+    double m_Window        = 10.0;  // [s]
+    size_t m_NumSegments   = 20;
+    double m_FixedDelay    = 0.0;   // known constant transport delay [s]
+    double m_JumpThreshold = 0.5;   // change of offset treated as a clock step [s]
+    double m_DelayWeight   = 0.01;  // smoothing weight of the delay average
+
+    // state
+    bool                m_HasReference = false;
+    double              m_Reference    = 0.0; // instrument time t0 [s]
+    std::deque<Segment> m_Segments;           // the last one is still being filled
+
+    bool   m_IsSynchronized = false;
+    double m_Offset         = 0.0; // envelope at the reference time [s]
+    double m_Skew           = 0.0;
+    double m_LastOffset     = 0.0;
+    double m_Delay          = 0.0;
+    size_t m_NumSamples     = 0;
+
+    std::vector<double> m_Slopes;
+
+}; // class: ClockSynchronizer
+
+#endif
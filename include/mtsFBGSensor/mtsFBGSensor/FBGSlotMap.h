@@ -0,0 +1,76 @@
+#ifndef _FBGSLOTMAP_H
+#define _FBGSLOTMAP_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cisstCommon.h>
+#include <cisstVector.h>
+
+// Named FBG and the wavelength window in which it is expected on a channel
+struct FBGSlot
+{
+    std::string Name;
+    size_t      Channel;       // 1-based channel number
+    double      WavelengthMin; // [nm]
+    double      WavelengthMax; // [nm]
+
+}; // struct: FBGSlot
+
+/*
+ * Assigns the peaks of one frame to a fixed list of FBG slots.
+ *
+ * Each channel's windows are kept sorted by wavelength, so a frame is mapped with a
+ * single merge walk over the (sorted) peaks and windows of each channel. Slots without
+ * a peak are NaN and flagged invalid; peaks outside every window are dropped and
+ * counted. If several peaks fall in one window, the one closest to its centre is kept.
+ */
+class CISST_EXPORT FBGSlotMap
+{
+public:
+    // configure from the "FBG_Slots" JSON array:
+    //   [{"Name": "CH1_AA1", "Channel": 1, "Window": [1525.0, 1535.0]}, ...]
+    void Configure(const Json::Value& jsonSlots);
+
+    // slot indices follow the order of the given slots; throws std::invalid_argument if windows of a channel overlap
+    void SetSlots(const std::vector<FBGSlot>& slots);
+
+    inline bool   IsConfigured()       const { return !m_Slots.empty(); }
+    inline size_t GetNumberOfSlots()   const { return m_Slots.size(); }
+    inline const std::vector<FBGSlot>& GetSlots() const { return m_Slots; }
+
+    // map one frame of peaks grouped per channel (element 0 is channel 1)
+    void Assign(const std::vector<vctDoubleVec>& channelPeaks, vctDoubleVec& slotPeaks, vctBoolVec& slotValid);
+
+    // channel (0-based) and index within that channel's peaks of the peak assigned to a slot by the last frame
+    struct PeakSource
+    {
+        size_t Channel;
+        size_t Index;
+    };
+    inline const PeakSource& GetSlotSource(const size_t slot) const { return m_SlotSources[slot]; }
+
+    // statistics of the last frame assigned
+    inline size_t GetNumberOfUnassignedPeaks() const { return m_NumUnassigned; }
+    inline size_t GetNumberOfConflicts()       const { return m_NumConflicts; }
+
+protected:
+    struct Window
+    {
+        double Min;
+        double Max;
+        size_t Slot;
+    };
+
+    std::vector<FBGSlot>             m_Slots;
+    std::vector<std::vector<Window>> m_ChannelWindows; // element 0 is channel 1, sorted by Min
+
+    std::vector<std::pair<double, size_t>> m_SortedPeaks; // wavelength and index in the channel's peaks
+    std::vector<PeakSource>                m_SlotSources;
+    size_t m_NumUnassigned = 0;
+    size_t m_NumConflicts  = 0;
+
+}; // class: FBGSlotMap
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef _INTERROGATOR_H
 #define _INTERROGATOR_H
 
+#include <cstdint>
+#include <limits>
+#include <vector>
+
 #include <cisstCommon.h>
 #include <cisstVector.h>
 
@@ -8,8 +12,18 @@ enum InterrogatorType{
     HYPERION,
     SI155 = HYPERION,
     SM130,
+    MULTI,
 }; // enum: InterrogatorType
 
+// Columns of the peak quality matrices
+enum PeakQualityMetric{
+    PEAK_AMPLITUDE,     // [dBm]
+    PEAK_FWHM,          // [nm]
+    PEAK_SNR,           // [dB]
+    PEAK_ASYMMETRY,     // (right - left half width) / FWHM
+    NUM_PEAK_QUALITY_METRICS,
+}; // enum: PeakQualityMetric
+
 
 class CISST_EXPORT Interrogator
 {
@@ -18,6 +32,8 @@ public:
     Interrogator(const Interrogator& interrogator) = default;
     virtual ~Interrogator(){} 
 
+    // Interrogator specific settings from the sensor's JSON configuration
+    virtual void Configure(const Json::Value& jsonConfig) {}
 
     // Abstract base class methods
     inline int  GetNumberOfPeaks(const size_t channelId) const { return this->GetPeaks(channelId).size(); }
@@ -30,21 +46,54 @@ public:
     virtual bool StreamPeaks()           { return GetIsStreaming(); }
     virtual bool DisableStreamPeaks()    { return !GetIsStreaming(); }
 
+    // Streaming rate control
+    virtual int  GetStreamingDivider() const        { return 1; }
+    virtual bool SetStreamingDivider(const int divider) { return false; }
+
+    // Streaming telemetry
+    virtual double GetStreamingRate()            const { return 0.0; } // achieved output rate in Hz (0 if unknown)
+    virtual size_t GetNumberOfQueuedFrames()     const { return 0; }   // samples received but not yet returned
+    virtual int    GetStreamingBufferAvailable() const { return 100; } // percent of the instrument's output buffer free
+    virtual size_t GetNumberOfCollapsedFrames()  const { return 1; }   // frames merged into the last peaks returned
+
     // Methods to get the peaks from a channel
     virtual vctDoubleVec GetPeaks(const size_t channelId) const = 0;
+
+    // Peaks of all channels grouped per channel (element 0 is channel 1); implementations
+    // should take them from a single frame so that the channels are consistent
+    virtual std::vector<vctDoubleVec> GetChannelPeaks() const
+    {
+        std::vector<vctDoubleVec> channelPeaks;
+        for (int chId = 1; chId <= this->GetNumberOfChannels(); chId++)
+            channelPeaks.push_back(this->GetPeaks(chId));
+
+        return channelPeaks;
+    }
+
+    // Quality of the peaks last returned by GetChannelPeaks, one row per peak and one column per
+    // PeakQualityMetric; empty when the interrogator only reports wavelengths
+    virtual std::vector<vctDoubleMat> GetChannelPeakQuality() const { return std::vector<vctDoubleMat>(); }
+
+    // Instrument time of the frame last returned by GetChannelPeaks in seconds (NaN if unknown)
+    virtual double GetPeaksTimestamp() const { return std::numeric_limits<double>::quiet_NaN(); }
+
+    // Instrument sweep number of that frame (-1 if unknown)
+    virtual int64_t GetPeaksSerialNumber() const { return -1; }
+
     virtual vctDoubleVec GetPeaks() const
     {
-        vctDoubleVec peaks = vctDoubleVec();
+        std::vector<vctDoubleVec> channelPeaks = this->GetChannelPeaks();
+
+        size_t numPeaks = 0;
+        for (const auto& peaks_chID : channelPeaks)
+            numPeaks += peaks_chID.size();
+
+        vctDoubleVec peaks = vctDoubleVec(numPeaks);
         size_t idx = 0;
-        for (int chId = 1; chId <= this->GetNumberOfChannels(); chId++)
-        {
-            auto peaks_chID = this->GetPeaks(chId);
-            peaks.SetSize(peaks.size() + peaks_chID.size());
+        for (const auto& peaks_chID : channelPeaks)
             for (auto peak : peaks_chID)
                 peaks[idx++] = peak;
 
-        }
-
         return peaks;
     }
 
@@ -61,6 +110,9 @@ class InterrogatorFactory
         static Interrogator* CreateInterrogator(const InterrogatorType& type, const std::string& ipAddress);
         static Interrogator* CreateInterrogator(const InterrogatorType& type, const std::string& ipAddress, const unsigned int port);
 
+        // case-insensitive "Interrogator_Type" name; returns false for an unknown name
+        static bool ParseInterrogatorType(std::string name, InterrogatorType& type);
+
 }; // class: InterrogatorFactory
 
 
@@ -0,0 +1,127 @@
+#ifndef _MULTI_INTERROGATOR_H
+#define _MULTI_INTERROGATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cisstCommon.h>
+
+#include "Interrogator.h"
+#include "ClockSynchronizer.h"
+#include "mtsFBGSensor/Utilities/RealTimeSettings.h"
+
+/*
+ * Aggregates several interrogators into one, e.g. for tools whose fibers are split across units.
+ *
+ * The channels of the backends are numbered one after the other in configuration order. While
+ * streaming, every backend is read by its own thread into a short frame buffer; each frame of the
+ * first (reference) backend is then merged with the frames of the others that are closest in time,
+ * either taking the nearest frame or interpolating linearly between the two that bracket it.
+ * A backend without a frame within the tolerance contributes no peaks to that merged frame.
+ *
+ * Instrument timestamps are mapped onto a common clock with a per-backend offset: either fixed
+ * "Clock_Offset"s relative to the reference backend's clock or, with "Estimate_Clock_Offsets",
+ * a ClockSynchronizer per backend mapping its timestamps onto the host clock.
+ */
+class MultiInterrogator : public Interrogator
+{
+    public:
+        enum class AlignmentMode {
+            NEAREST,
+            LINEAR,
+        }; // enum: AlignmentMode
+
+        MultiInterrogator();
+        ~MultiInterrogator();
+
+        // "Interrogators": [{"Interrogator_Type", "IP_Address", "Channels", "Clock_Offset", ...}, ...]
+        // "Alignment":     {"Mode", "Tolerance", "Buffer_Size", "Estimate_Clock_Offsets", "Clock_Synchronization"}
+        void Configure(const Json::Value& jsonConfig) override;
+
+        // Abstract base class methods
+        int GetNumberOfChannels() const override;
+
+        bool Connect() override;
+        bool Disconnect() override;
+
+        bool StreamPeaks() override;
+        bool DisableStreamPeaks() override;
+
+        // Streaming rate control (applied to every backend)
+        int  GetStreamingDivider() const override;
+        bool SetStreamingDivider(const int divider) override;
+
+        // Streaming telemetry (of the reference backend, which paces the merged frames)
+        double GetStreamingRate()            const override;
+        size_t GetNumberOfQueuedFrames()     const override;
+        int    GetStreamingBufferAvailable() const override;
+        size_t GetNumberOfCollapsedFrames()  const override;
+
+        // Methods to get the peaks from a channel
+        vctDoubleVec GetPeaks(const size_t channelId) const override;
+
+        std::vector<vctDoubleVec> GetChannelPeaks()       const override;
+        std::vector<vctDoubleMat> GetChannelPeakQuality() const override { return m_Merged.Quality; }
+        double                    GetPeaksTimestamp()     const override { return m_Merged.Time; }
+        int64_t                   GetPeaksSerialNumber()  const override { return m_Merged.SerialNumber; }
+
+        // Alignment telemetry
+        inline size_t GetNumberOfBackends()        const { return m_Backends.size(); }
+        inline size_t GetNumberOfUnalignedFrames() const { return m_NumUnaligned; }
+        double        GetClockOffset(const size_t backend) const;
+
+    private:
+        // One frame of a backend, its time mapped onto the common clock
+        struct Frame
+        {
+            double                    Time         = std::numeric_limits<double>::quiet_NaN();
+            int64_t                   SerialNumber = -1; // of the backend's frame (the reference's once merged)
+            std::vector<vctDoubleVec> ChannelPeaks;
+            std::vector<vctDoubleMat> Quality;
+        };
+
+        struct Backend
+        {
+            std::unique_ptr<Interrogator> Device;
+            size_t NumChannels = 0;     // channels contributed to the merged frame (0 queries the device)
+
+            std::atomic<double> ClockOffset{0.0}; // common time = instrument time + offset [s]
+            ClockSynchronizer   Synchronizer;     // used by the reader thread only
+
+            std::mutex DeviceMutex;     // the backend is read by its thread and controlled by the sensor's
+
+            std::deque<Frame>       Frames;
+            std::mutex              FramesMutex;
+            std::condition_variable FrameCondition;
+            std::thread             Reader;
+        };
+
+        std::vector<std::unique_ptr<Backend>> m_Backends;
+
+        AlignmentMode m_Mode       = AlignmentMode::NEAREST;
+        double        m_Tolerance  = 0.001; // [s]
+        size_t        m_BufferSize = 64;    // frames buffered per backend
+        bool          m_EstimateClockOffsets = false;
+
+        std::atomic<bool> m_StopReaders{false};
+        RealTimeSettings  m_ReaderRealTimeSettings; // the sensor's "Real_Time" settings, applied to every reader
+
+        mutable Frame  m_Merged;
+        mutable size_t m_NumUnaligned = 0;
+
+        void  ReaderLoop(Backend& backend, const size_t index);
+        Frame ReadFrame(Backend& backend) const;
+        bool  AlignFrame(Backend& backend, const double time, Frame& aligned) const;
+        void  MergeFrames(const std::vector<Frame>& frames, const std::vector<bool>& aligned) const;
+
+        void StopReaders();
+
+}; // class: MultiInterrogator
+
+#endif
@@ -1,10 +1,26 @@
 #ifndef _MTSFBGSENSOR_H
 #define _MTSFBGSENSOR_H
 
+#include <limits>
+
 #include <cisstCommon.h>
 #include <cisstMultiTask.h>
 
 #include "Interrogator.h"
+#include "FBGSlotMap.h"
+#include "ClockSynchronizer.h"
+#include "mtsFBGSensor/Utilities/RealTimeSettings.h"
+#include "mtsFBGSensor/Utilities/SubscriberList.h"
+
+// One frame of peaks, as handed to the in-process subscribers of mtsFBGSensor
+struct FBGPeaksFrame
+{
+    double       Time         = std::numeric_limits<double>::quiet_NaN(); // host time of acquisition [s]
+    int64_t      SerialNumber = -1;                                       // -1 if the interrogator has none
+    vctDoubleVec Peaks;
+    vctBoolVec   PeaksValid;
+
+}; // struct: FBGPeaksFrame
 
 class CISST_EXPORT mtsFBGSensor : public mtsTaskContinuous 
 {
@@ -26,18 +42,114 @@ public:
     inline void GetNumberOfChannels(mtsUInt& number)                        const { number.Data = m_Interrogator->GetNumberOfChannels(); }
     inline void GetNumberOfPeaks(const mtsUInt& channelId, mtsUInt& number) const { number.Data = m_Interrogator->GetNumberOfPeaks(channelId.Data); }
 
+    void GetFBGSlotNames(mtsStdStringVec& names) const;
+
     inline void Connect(mtsBool& success)    { success.Data = m_Interrogator->Connect(); }
     inline void Disconnect(mtsBool& success) { success.Data = m_Interrogator->Disconnect(); }
 
+    void ResetSweepCounters(void);
+
+    inline void GetRealTimeReport(mtsStdString& report) const { report = m_RealTimeReport; }
+
+    // In-process consumers of every new frame, notified on the acquisition thread before the
+    // mts state table is advanced; callbacks must not block
+    typedef SubscriberList<FBGPeaksFrame>::Callback PeaksCallback;
+
+    inline size_t AddPeaksSubscriber(const PeaksCallback& callback)                            { return m_PeaksSubscribers.Add(callback); }
+    inline size_t AddPeaksSubscriber(const std::shared_ptr<TripleBuffer<FBGPeaksFrame>>& latest) { return m_PeaksSubscribers.Add(latest); }
+    inline bool   RemovePeaksSubscriber(const size_t id)                                         { return m_PeaksSubscribers.Remove(id); }
+
 protected:
     void Init(void);
     void SetupInterfaces(void);
+    void AdaptStreamingRate(void);
+    void UpdatePeakQuality(void);
+    void UpdatePeaksTimestamp(void);
+    bool UpdateSweepCounters(void); // false for a duplicated frame
 
     mtsStateTable m_StateTable;
     mtsDoubleVec  m_Peaks;
+    mtsBoolVec    m_PeaksValid;              // per FBG slot (all true without slots)
+    mtsUInt       m_NumberOfUnassignedPeaks; // peaks outside every FBG slot window
+    mtsDoubleMat  m_PeakQuality;             // one row per peak, one column per PeakQualityMetric
+    mtsDouble     m_PeaksTimestamp;          // host (system clock) time at which the peaks were acquired [s]
+
+    // Instrument clock synchronization
+    mtsDouble     m_ClockOffset;             // host - instrument time [s]
+    mtsDouble     m_ClockSkew;               // drift of the host clock relative to the instrument's [s/s]
+    mtsDouble     m_NetworkDelay;            // mean receive delay after acquisition [s]
+
+    // Streaming telemetry
+    mtsDouble     m_StreamingRate;
+    mtsInt        m_StreamingBufferAvailable;
+    mtsUInt       m_NumberOfCollapsedFrames;
+    mtsUInt       m_NumberOfQueuedFrames;
+    mtsDouble     m_FrameProcessingTime;     // from receiving a frame to handing it off [s]
+
+    // Sweep loss telemetry
+    mtsUInt       m_NumberOfDroppedSweeps;
+    mtsUInt       m_NumberOfDuplicatedSweeps;
+    mtsDouble     m_LongestGap;              // longest time between two consecutive frames [s]
+
+    // What the "Real_Time" settings applied to the acquisition thread
+    mtsStdString  m_RealTimeReport;
+
+    // Events
+    mtsFunctionWrite m_StreamingRateChangedEvent;
+    mtsFunctionWrite m_SweepsDroppedEvent;   // sweeps dropped since the last event
+    mtsFunctionWrite m_SweepGapEvent;        // time between two consecutive frames [s]
+    mtsFunctionWrite m_PeaksSampleEvent;     // every new frame's peaks, stamped with m_PeaksTimestamp
 
 private:
-    Interrogator* m_Interrogator;
+    Interrogator* m_Interrogator = nullptr;
+    bool          m_StreamPeaks  = true;
+
+    // Direct hand-off of every frame to in-process consumers
+    FBGPeaksFrame                 m_PeaksFrame;
+    SubscriberList<FBGPeaksFrame> m_PeaksSubscribers;
+
+    // Scheduling of the acquisition (this task's) thread
+    RealTimeSettings m_RealTimeSettings;
+
+    // Fixed FBG layout of m_Peaks (unused when no "FBG_Slots" are configured)
+    FBGSlotMap    m_SlotMap;
+
+    // Maps the instrument's frame timestamps onto the host clock
+    ClockSynchronizer m_ClockSynchronizer;
+
+    // Peaks whose quality is outside these limits are flagged invalid (NaN disables a limit)
+    struct {
+        double MinSNR       = std::numeric_limits<double>::quiet_NaN(); // [dB]
+        double MaxFWHM      = std::numeric_limits<double>::quiet_NaN(); // [nm]
+        double MaxAsymmetry = std::numeric_limits<double>::quiet_NaN(); // absolute value
+    } m_PeakQualityLimits;
+
+    // Dropped and duplicated sweep detection from the frames' serial numbers and timestamps
+    struct {
+        size_t  DropThreshold = 10;  // dropped sweeps that raise SweepsDropped (0 disables the event)
+        double  GapThreshold  = 0.0; // time between frames that raises SweepGap [s] (0 disables the event)
+
+        int64_t LastSerialNumber = -1;
+        double  LastTime         = std::numeric_limits<double>::quiet_NaN();
+        int     Divider          = 1;
+        int64_t SerialStep       = 0; // smallest serial increment seen at this divider
+        size_t  NumDroppedSinceEvent = 0;
+    } m_SweepMonitor;
+
+    // Runtime adaptation of the streaming divider to the consumer load
+    struct {
+        bool   Enabled                 = false;
+        size_t QueueHigh               = 16;   // queued frames above which the rate is reduced
+        size_t QueueLow                = 1;    // queued frames at or below which the rate may be restored
+        double MaxProcessingFraction   = 0.8;  // processing time per frame, as a fraction of the frame period, above which the rate is reduced
+        size_t HoldCycles              = 200;  // consecutive overloaded frames before reducing the rate
+        size_t RestoreCycles           = 2000; // consecutive idle frames before restoring the rate
+        int    MaxDivider              = 64;
+
+        int    BaseDivider             = 1;
+        size_t OverloadCount           = 0;
+        size_t UnderloadCount          = 0;
+    } m_RateAdaptation;
 
 
 }; // class: mtsFBGSensor
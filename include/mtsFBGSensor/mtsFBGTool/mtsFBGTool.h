@@ -1,10 +1,31 @@
 #pragma once
+#include <cmath>
+#include <limits>
 #include <memory>
 
 #include <cisstMultiTask.h>
 
 #include "FBGToolInterface.h"
+#include "mtsFBGSensor/SensorFilters/CommonModeCompensator.h"
+#include "mtsFBGSensor/SensorFilters/FilterBank.h"
+#include "mtsFBGSensor/SensorFilters/HampelFilter.h"
 #include "mtsFBGSensor/SensorFilters/SensorOneEuroFilter.h"
+#include "mtsFBGSensor/SensorFilters/UniformResampler.h"
+#include "mtsFBGSensor/SensorFilters/SignalEstimator.h"
+#include "mtsFBGSensor/Utilities/RealTimeSettings.h"
+#include "mtsFBGSensor/Utilities/SubscriberList.h"
+#include "mtsFBGSensor/Utilities/WelfordStatistics.h"
+
+// One force estimate, as handed to the in-process subscribers of mtsFBGTool
+struct FBGForceEstimate
+{
+    double Time             = std::numeric_limits<double>::quiet_NaN(); // sample time of the peaks [s]
+    vct6   ForcesTip        = vct6(0.0); // [Fx, Fy, Fz, Tx, Ty, Tz]
+    vct6   ForcesSclera     = vct6(0.0); // [Fx, Fy, Fz, Tx, Ty, Tz]
+    double ForcesTipNorm    = 0.0;
+    double ForcesScleraNorm = 0.0;
+
+}; // struct: FBGForceEstimate
 
 class CISST_EXPORT mtsFBGTool : public mtsTaskContinuous
 {
@@ -19,9 +40,40 @@ public:
     void Run(void);
     void Cleanup(void);
 
+    inline void GetRealTimeReport(mtsStdString& report) const { report = m_RealTimeReport; }
+
+    // empty until a tool is configured
+    inline void GetToolName(mtsStdString& toolName) const { toolName = m_FBGTool ? m_FBGTool->GetToolName() : mtsStdString(""); }
+
+    // Starts estimating the base wavelengths from the next frames while the forces keep coming
+    void Tare(void);
+
+    // In-process consumers of every new estimate, notified on this task's thread as soon as it is
+    // computed (before the mts state table and events); callbacks must not block
+    typedef SubscriberList<FBGForceEstimate>::Callback EstimateCallback;
+
+    inline size_t AddEstimateSubscriber(const EstimateCallback& callback)                               { return m_EstimateSubscribers.Add(callback); }
+    inline size_t AddEstimateSubscriber(const std::shared_ptr<TripleBuffer<FBGForceEstimate>>& latest) { return m_EstimateSubscribers.Add(latest); }
+    inline bool   RemoveEstimateSubscriber(const size_t id)                                             { return m_EstimateSubscribers.Remove(id); }
+
 protected:
     void SetupInterfaces(void);
 
+    // fill the peak container with the new sensor samples; returns the time of the newest one
+    double UpdatePeakSamples(void);
+
+    // add one sample to the outlier filter, the peak container, the wavelength filters and the estimator
+    void AddPeakSample(const double time, const vctDoubleVec& peaks);
+
+    // add one frame to a running tare; swaps the base wavelengths in when it is complete
+    void UpdateTare(const double time, const vctDoubleVec& peaks);
+
+    // these stages take every sensor frame once, the peak container's mean alone a window of them
+    inline bool UsesEverySample() const
+    {
+        return m_OutlierFilter.IsEnabled() || m_WavelengthFilters.IsEnabled() || m_Estimator.IsEnabled();
+    }
+
 private:
     mtsStateTable                     m_StateTable;
     std::shared_ptr<FBGToolInterface> m_FBGTool;
@@ -29,7 +81,7 @@ private:
     // Container to handle number of peaks
     struct {
         mtsDoubleMat Peaks;
-        size_t       CurrentIndex;
+        size_t       CurrentIndex = 0;
         size_t       NumSamples = 200;
         bool         IsFull = false;
         bool         IsConfigured = false;
@@ -37,16 +89,20 @@ private:
         void Configure(size_t numPeakSignals, size_t numSamples = 0)
         {
             if (numSamples > 0)
-                NumSamples = NumSamples;
+                NumSamples = numSamples;
             
             Peaks.SetSize(NumSamples, numPeakSignals);
             Peaks.Zeros();
             IsConfigured = true;
         }
 
-        void Update(const mtsDoubleVec& peaks)
+        void Update(const vctDoubleVec& peaks)
         {
-            Peaks[CurrentIndex++] = peaks;
+            // FBG slots the sensor did not see (NaN) hold their previous value
+            size_t previousIndex = (CurrentIndex + NumSamples - 1) % NumSamples;
+            for (size_t i = 0; i < peaks.size(); i++)
+                Peaks.Element(CurrentIndex, i) = std::isnan(peaks[i]) ? Peaks.Element(previousIndex, i) : peaks[i];
+            CurrentIndex++;
             if (CurrentIndex >= NumSamples)
             {
                 IsFull        = true; 
@@ -76,8 +132,69 @@ private:
     
     mtsDoubleVec m_ForcesDirection;
 
+    // Every new estimate as [Fx, Fy, Fz, Tx, Ty, Tz], stamped with its sample time
+    mtsDoubleVec m_ForcesTipSample;
+    mtsDoubleVec m_ForcesScleraSample;
+
+    mtsFunctionWrite m_ForcesTipSampleEvent;
+    mtsFunctionWrite m_ForcesScleraSampleEvent;
+
+    // Direct hand-off of every estimate to in-process consumers
+    FBGForceEstimate                 m_Estimate;
+    SubscriberList<FBGForceEstimate> m_EstimateSubscribers;
+
+    // Resampling telemetry
+    mtsBool      m_ResamplingGap;           // the last resampled frame was interpolated across a gap
+    mtsUInt      m_NumberOfGapSamples;
+
+    // Peaks replaced by the outlier filter since the start
+    mtsUInt      m_NumberOfOutliers;
+
+    // Common-mode shift of every temperature compensation group
+    mtsDoubleVec m_CommonModeShifts;
+
+    // Tare: base wavelengths in use, and every FBG's peak standard deviation during the last tare [nm]
+    mtsDoubleVec m_BaseWavelengths;
+    mtsDoubleVec m_NoiseFloor;
+    mtsBool      m_TareActive;
+
+    mtsFunctionWrite m_TareCompletedEvent;
+
     // Member functions
     mtsFunctionRead m_ReadStateFBGPeaks;
+    mtsFunctionRead m_ReadStateFBGPeaksTimestamp;
+
+    // Optional replacement of outlier peaks, ahead of everything else
+    HampelFilter m_OutlierFilter;
+    vctDoubleVec m_CleanPeaks;
+
+    // Optional filters and causal estimator of the wavelength shifts, in place of the peak container's mean
+    FilterBank      m_WavelengthFilters;
+    SignalEstimator m_Estimator;
+    vctDoubleVec    m_NewestPeaks;      // newest row of the peak container
+    mtsDoubleVec    m_WavelengthShifts; // of the newest peaks, filtered
+
+    // Tare statistics of the raw peaks, one frame at a time
+    WelfordStatistics m_TareStatistics;
+    size_t            m_TareNumSamples = 1000;
+    size_t            m_TareNumFrames  = 0;
+    double            m_TareLastTime   = std::numeric_limits<double>::quiet_NaN();
+    bool              m_TareOnStartup  = false;
+
+    // Optional removal of the FBG groups' common-mode (temperature) shifts before calibration
+    CommonModeCompensator m_TemperatureCompensation;
+
+    // Optional filters of the tip and sclera forces (one channel per component)
+    FilterBank   m_ForceFilters;
+    vctDoubleVec m_ForceSample;
+
+    // Optional uniform time grid for the peaks (by their hardware timestamps)
+    UniformResampler m_Resampler;
+    double           m_LastPeaksTimestamp = -1; // of the last sensor frame used without resampling
+
+    // Scheduling of this task's thread and what was applied
+    RealTimeSettings m_RealTimeSettings;
+    mtsStdString     m_RealTimeReport;
 
     // Sensor Filters
     sensorOneEuroFilter m_FilterOneEuroScleraForceX;